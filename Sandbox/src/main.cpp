@@ -40,18 +40,20 @@ int main(int argc, char* argv[])
         options.SetHlslIoMapping(true); // Note: Needed for `register(b0, space0)` layout
     }
 
-    shaderc::SpvCompilationResult module = compiler.CompileGlslToSpv(std::string(g_Fragment), shaderc_fragment_shader, "", options);
+    // Compile straight into the output vector, sized for typical shaders
+    std::vector<char> spirv(64 * 1024);
+    shaderc::SpvCompilationResult module = compiler.CompileGlslToSpvBuffer(g_Fragment.data(), g_Fragment.size(), shaderc_fragment_shader, "", "main", options, spirv.data(), spirv.size());
 
     if (!(module.GetCompilationStatus() == shaderc_compilation_status_success))
         std::cerr << "Error compiling shader: " << module.GetErrorMessage() << std::endl;
 
-    // Convert SPIR-V code to vector<char>
-    const uint32_t* data = module.cbegin();
+    // Shrink to the SPIR-V code, or take it from the result if it didn't fit
     const size_t numWords = module.cend() - module.cbegin();
     const size_t sizeInBytes = numWords * sizeof(uint32_t);
-    const char* bytes = reinterpret_cast<const char*>(data);
-
-    std::vector<char> spirv(bytes, bytes + sizeInBytes);
+    if (sizeInBytes <= spirv.size())
+        spirv.resize(sizeInBytes);
+    else
+        spirv.assign(reinterpret_cast<const char*>(module.cbegin()), reinterpret_cast<const char*>(module.cend()));
 	
     return 0;
 }
\ No newline at end of file
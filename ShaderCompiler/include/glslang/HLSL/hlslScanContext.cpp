@@ -39,12 +39,11 @@
 //
 
 #include <cstring>
-#include <unordered_map>
-#include <unordered_set>
 
 #include "../Include/Types.h"
 #include "../MachineIndependent/SymbolTable.h"
 #include "../MachineIndependent/ParseHelper.h"
+#include "../MachineIndependent/KeywordTable.h"
 #include "hlslScanContext.h"
 #include "hlslTokens.h"
 
@@ -54,31 +53,8 @@
 
 namespace {
 
-struct str_eq
-{
-    bool operator()(const char* lhs, const char* rhs) const
-    {
-        return strcmp(lhs, rhs) == 0;
-    }
-};
-
-struct str_hash
-{
-    size_t operator()(const char* str) const
-    {
-        // djb2
-        unsigned long hash = 5381;
-        int c;
-
-        while ((c = *str++) != 0)
-            hash = ((hash << 5) + hash) + c;
-
-        return hash;
-    }
-};
-
 // A single global usable by all threads, by all versions, by all languages.
-const std::unordered_map<const char*, glslang::EHlslTokenClass, str_hash, str_eq> KeywordMap {
+constexpr glslang::TKeywordEntry<glslang::EHlslTokenClass> KeywordList[] = {
     {"static",glslang::EHTokStatic},
     {"const",glslang::EHTokConst},
     {"unorm",glslang::EHTokUnorm},
@@ -436,8 +412,9 @@ const std::unordered_map<const char*, glslang::EHlslTokenClass, str_hash, str_eq
     {"case",glslang::EHTokCase},
     {"default",glslang::EHTokDefault},
 };
+constexpr glslang::TKeywordTable KeywordMap(KeywordList);
 
-const std::unordered_set<const char*, str_hash, str_eq> ReservedSet {
+constexpr glslang::TKeywordEntry<bool> ReservedList[] = {
     "auto",
     "catch",
     "char",
@@ -467,7 +444,9 @@ const std::unordered_set<const char*, str_hash, str_eq> ReservedSet {
     "using",
     "virtual",
 };
-std::unordered_map<const char*, glslang::TBuiltInVariable, str_hash, str_eq> SemanticMap { 
+constexpr glslang::TKeywordTable ReservedSet(ReservedList);
+
+constexpr glslang::TKeywordEntry<glslang::TBuiltInVariable> SemanticList[] = {
 
     // in DX9, all outputs had to have a semantic associated with them, that was either consumed
     // by the system or was a specific register assignment
@@ -508,6 +487,7 @@ std::unordered_map<const char*, glslang::TBuiltInVariable, str_hash, str_eq> Sem
     {"SV_DEPTHLESSEQUAL",glslang::EbvFragDepthLesser},
     {"SV_STENCILREF", glslang::EbvFragStencilRef},
 };
+constexpr glslang::TKeywordTable SemanticMap(SemanticList);
 }
 
 namespace glslang {
@@ -521,9 +501,9 @@ void HlslScanContext::tokenize(HlslToken& token)
 
 glslang::TBuiltInVariable HlslScanContext::mapSemantic(const char* upperCase)
 {
-    auto it = SemanticMap.find(upperCase);
-    if (it != SemanticMap.end())
-        return it->second;
+    const glslang::TBuiltInVariable* it = SemanticMap.find(upperCase);
+    if (it != nullptr)
+        return *it;
     else
         return glslang::EbvNone;
 }
@@ -638,15 +618,16 @@ EHlslTokenClass HlslScanContext::tokenizeClass(HlslToken& token)
 
 EHlslTokenClass HlslScanContext::tokenizeIdentifier()
 {
-    if (ReservedSet.find(tokenText) != ReservedSet.end())
+    const TKeywordText text(tokenText);
+    if (ReservedSet.contains(text))
         return reservedWord();
 
-    auto it = KeywordMap.find(tokenText);
-    if (it == KeywordMap.end()) {
+    const EHlslTokenClass* it = KeywordMap.find(text);
+    if (it == nullptr) {
         // Should have an identifier of some sort
         return identifierOrType();
     }
-    keyword = it->second;
+    keyword = *it;
 
     switch (keyword) {
 
@@ -137,6 +137,27 @@ private:
 #   endif
 };
 
+//
+// Tuning for a pool, for compiles large enough that the default 8 KB pages
+// show up in the profile.  The defaults behave like the plain constructor.
+//
+struct TPoolAllocatorOptions {
+    // Granularity of allocation from the OS.
+    size_t pageSize = 8*1024;
+
+    // Back pages with transparent huge pages where the OS supports them
+    // (Linux); pageSize is then rounded up to a multiple of 2 MB.
+    bool hugePages = false;
+
+    // When the pool is destroyed, up to this many bytes of its pages, and of
+    // the multi-page allocations it popped or still holds, stay with the
+    // destroying thread and are handed to the next pool on that thread with
+    // the same kind of page, instead of going back to the OS.  With no limit,
+    // a thread that runs similar compiles keeps one arena's worth of memory
+    // and stops allocating from the OS after the first.
+    size_t recycleBytes = 0;
+};
+
 //
 // There are several stacks.  One is to track the pushing and popping
 // of the user, and not yet implemented.  The others are simply a
@@ -144,8 +165,8 @@ private:
 //
 // Page stacks are linked together with a simple header at the beginning
 // of each allocation obtained from the underlying OS.  Multi-page allocations
-// are returned to the OS.  Individual page allocations are kept for future
-// re-use.
+// are returned to the OS, or recycled (see TPoolAllocatorOptions).  Individual
+// page allocations are kept for future re-use.
 //
 // The "page size" used is not, nor must it match, the underlying OS
 // page size.  But, having it be about that size or equal to a set of
@@ -154,6 +175,7 @@ private:
 class TPoolAllocator {
 public:
     TPoolAllocator(int growthIncrement = 8*1024, int allocationAlignment = 16);
+    explicit TPoolAllocator(const TPoolAllocatorOptions& options, int allocationAlignment = 16);
 
     //
     // Don't call the destructor just to free up the memory, call pop()
@@ -184,6 +206,16 @@ public:
     GLSLANG_EXPORT_FOR_TESTS
     void* allocate(size_t numBytes);
 
+    // Number of bytes handed out by allocate() over the lifetime of the pool,
+    // not counting alignment padding or headers.
+    size_t getTotalBytes() const { return totalBytes; }
+
+    // Number of times the pool asked the OS for memory, and the number of bytes
+    // it asked for, over the lifetime of the pool.  Pages taken from the free
+    // list or recycled from an earlier pool don't count.
+    size_t getSystemAllocations() const { return systemAllocations; }
+    size_t getSystemBytes() const { return systemBytes; }
+
     //
     // There is no deallocate.  The point of this class is that
     // deallocation can be skipped by the user of it, as the model
@@ -234,6 +266,10 @@ protected:
         return TAllocation::offsetAllocation(memory);
     }
 
+    void initialize(int allocationAlignment);
+    tHeader* newPages(size_t& pageCount);
+    void releasePages(tHeader* pages, size_t pageCount);
+
     size_t pageSize;        // granularity of allocation from the OS
     size_t alignment;       // all returned allocations will be aligned at
                             //      this granularity, which will be a power of 2
@@ -246,8 +282,13 @@ protected:
     tHeader* inUseList;     // list of all memory currently being used
     tAllocStack stack;      // stack of where to allocate from, to partition pool
 
+    bool hugePages;         // single pages are huge-page backed
+    size_t recycleBytes;    // see TPoolAllocatorOptions
+
     int numCalls;           // just an interesting statistic
     size_t totalBytes;      // just an interesting statistic
+    size_t systemAllocations;  // just an interesting statistic
+    size_t systemBytes;     // just an interesting statistic
 private:
     TPoolAllocator& operator=(const TPoolAllocator&);  // don't allow assignment operator
     TPoolAllocator(const TPoolAllocator&);  // don't allow default copy constructor
@@ -262,6 +303,11 @@ GLSLANG_EXPORT_FOR_TESTS
 extern TPoolAllocator& GetThreadPoolAllocator();
 void SetThreadPoolAllocator(TPoolAllocator* poolAllocator);
 
+// Options for the pools that TShader and TProgram objects constructed on the
+// calling thread create.
+GLSLANG_EXPORT const TPoolAllocatorOptions& GetThreadPoolAllocatorOptions();
+GLSLANG_EXPORT void SetThreadPoolAllocatorOptions(const TPoolAllocatorOptions& options);
+
 //
 // This STL compatible allocator is intended to be used as the allocator
 // parameter to templatized STL containers, like vector and map.
@@ -505,6 +505,7 @@ public:
         invariant = false;
         makeTemporary();
         declaredBuiltIn = EbvNone;
+        explicitOffset = false;
         noContraction = false;
         nullInit = false;
         spirvByReference = false;
@@ -531,6 +532,30 @@ public:
         spirvLiteral = false;
     }
 
+    // True when this qualifier differs from a clear()ed one in nothing but storage
+    // and precision.  Every data member is checked, so a new member must be added here.
+    bool hasOnlyStorageAndPrecision() const
+    {
+        return semanticName == nullptr && builtIn == EbvNone && declaredBuiltIn == EbvNone &&
+               ! invariant && ! isInterpolation() && ! isAuxiliary() && ! perPrimitiveNV && ! perViewNV &&
+               ! perTaskNV && ! isMemory() && ! specConstant && ! nonUniform && ! explicitOffset &&
+               ! defaultBlock && ! noContraction && ! nullInit && ! spirvByReference && ! spirvLiteral &&
+               layoutMatrix == ElmNone && layoutPacking == ElpNone &&
+               layoutOffset == layoutNotSet && layoutAlign == layoutNotSet &&
+               layoutLocation == layoutLocationEnd && layoutComponent == layoutComponentEnd &&
+               layoutSet == layoutSetEnd && layoutBinding == layoutBindingEnd &&
+               layoutIndex == layoutIndexEnd && layoutStream == layoutStreamEnd &&
+               layoutXfbBuffer == layoutXfbBufferEnd && layoutXfbStride == layoutXfbStrideEnd &&
+               layoutXfbOffset == layoutXfbOffsetEnd && layoutAttachment == layoutAttachmentEnd &&
+               layoutSpecConstantId == layoutSpecConstantIdEnd &&
+               layoutBufferReferenceAlign == layoutBufferReferenceAlignEnd && layoutFormat == ElfNone &&
+               ! layoutPushConstant && ! layoutBufferReference && ! layoutPassthrough &&
+               ! layoutViewportRelative && layoutSecondaryViewportRelativeOffset == -2048 &&
+               ! layoutShaderRecord && ! layoutFullQuads && ! layoutQuadDeriv &&
+               ! layoutHitObjectShaderRecordNV && spirvStorageClass == -1 && spirvDecorate == nullptr &&
+               ! layoutBindlessSampler && ! layoutBindlessImage && ! layoutTileAttachmentQCOM;
+    }
+
     void clearInterstage()
     {
         clearInterpolation();
@@ -1772,6 +1797,12 @@ public:
                             }
     virtual ~TType() {}
 
+    // If 'type' is a plain scalar, vector, matrix, or void type whose qualifier carries
+    // nothing but storage and precision, return the process-wide interned TType equal
+    // to it, else nullptr.  Interned types are immutable, never freed, and safe to share
+    // across threads and pools, so identical plain types also compare equal by address.
+    static const TType* findInterned(const TType& type);
+
     // Not for use across pool pops; it will cause multiple instances of TType to point to the same information.
     // This only works if that information (like a structure's list of types) does not change and
     // the instances are sharing the same pool.
@@ -2918,6 +2949,8 @@ public:
     // See if two types match in all ways (just the actual type, not qualification)
     bool operator==(const TType& right) const
     {
+        if (this == &right)
+            return true;
         return sameElementType(right) && sameArrayness(right) && sameTypeParameters(right) && sameCoopMatUse(right) && sameSpirvType(right);
     }
 
@@ -1085,39 +1085,53 @@ struct TIntermNodePair {
 //
 // Intermediate class for nodes that have a type.
 //
+// Most nodes carry a plain numeric, bool, or void type that differs from every other
+// node of the same shape only in storage and precision.  Those nodes share one interned,
+// immutable TType (see TType::findInterned()) instead of each holding its own copy.
+// The first request for a writable type gives the node a private copy, which it then
+// keeps for the rest of its life, so references handed out by getWritableType() stay valid.
+//
 class TIntermTyped : public TIntermNode {
 public:
-    TIntermTyped(const TType& t) { type.shallowCopy(t); }
-    TIntermTyped(TBasicType basicType) { TType bt(basicType); type.shallowCopy(bt); }
+    TIntermTyped(const TType& t) : type(nullptr), writableType(nullptr) { assignType(t); }
+    TIntermTyped(TBasicType basicType) : type(nullptr), writableType(nullptr) { TType bt(basicType); assignType(bt); }
     virtual       TIntermTyped* getAsTyped()       { return this; }
     virtual const TIntermTyped* getAsTyped() const { return this; }
-    virtual void setType(const TType& t) { type.shallowCopy(t); }
-    virtual const TType& getType() const { return type; }
-    virtual TType& getWritableType() { return type; }
-
-    virtual TBasicType getBasicType() const { return type.getBasicType(); }
-    virtual TQualifier& getQualifier() { return type.getQualifier(); }
-    virtual const TQualifier& getQualifier() const { return type.getQualifier(); }
-    virtual TArraySizes* getArraySizes() { return type.getArraySizes(); }
-    virtual const TArraySizes* getArraySizes() const { return type.getArraySizes(); }
+    virtual void setType(const TType& t) { assignType(t); }
+    virtual const TType& getType() const { return *type; }
+    virtual TType& getWritableType();
+
+    // Qualifier-only changes; a node sharing an interned type moves to the interned
+    // type with the new qualifier, when there is one, rather than taking a copy.
+    void setQualifier(const TQualifier&);
+    void setStorage(TStorageQualifier);
+    void setPrecision(TPrecisionQualifier);
+
+    virtual TBasicType getBasicType() const { return type->getBasicType(); }
+    virtual const TQualifier& getQualifier() const { return type->getQualifier(); }
+    virtual TArraySizes* getArraySizes() { return writableType != nullptr ? writableType->getArraySizes() : nullptr; }
+    virtual const TArraySizes* getArraySizes() const { return type->getArraySizes(); }
     virtual void propagatePrecision(TPrecisionQualifier);
-    virtual int getVectorSize() const { return type.getVectorSize(); }
-    virtual int getMatrixCols() const { return type.getMatrixCols(); }
-    virtual int getMatrixRows() const { return type.getMatrixRows(); }
-    virtual bool isMatrix() const { return type.isMatrix(); }
-    virtual bool isArray()  const { return type.isArray(); }
-    virtual bool isVector() const { return type.isVector(); }
-    virtual bool isScalar() const { return type.isScalar(); }
-    virtual bool isStruct() const { return type.isStruct(); }
-    virtual bool isFloatingDomain() const { return type.isFloatingDomain(); }
-    virtual bool isIntegerDomain() const { return type.isIntegerDomain(); }
-    bool isAtomic() const { return type.isAtomic(); }
-    bool isReference() const { return type.isReference(); }
-    TString getCompleteString(bool enhanced = false) const { return type.getCompleteString(enhanced); }
+    virtual int getVectorSize() const { return type->getVectorSize(); }
+    virtual int getMatrixCols() const { return type->getMatrixCols(); }
+    virtual int getMatrixRows() const { return type->getMatrixRows(); }
+    virtual bool isMatrix() const { return type->isMatrix(); }
+    virtual bool isArray()  const { return type->isArray(); }
+    virtual bool isVector() const { return type->isVector(); }
+    virtual bool isScalar() const { return type->isScalar(); }
+    virtual bool isStruct() const { return type->isStruct(); }
+    virtual bool isFloatingDomain() const { return type->isFloatingDomain(); }
+    virtual bool isIntegerDomain() const { return type->isIntegerDomain(); }
+    bool isAtomic() const { return type->isAtomic(); }
+    bool isReference() const { return type->isReference(); }
+    TString getCompleteString(bool enhanced = false) const { return type->getCompleteString(enhanced); }
 
 protected:
     TIntermTyped& operator=(const TIntermTyped&);
-    TType type;
+    void assignType(const TType&);
+
+    const TType* type;   // always valid; either the interned type or writableType
+    TType* writableType; // nullptr until this node needs its own copy of the type
 };
 
 //
@@ -1340,11 +1354,11 @@ public:
     void setOperationPrecision(TPrecisionQualifier p) { operationPrecision = p; }
     TPrecisionQualifier getOperationPrecision() const { return operationPrecision != EpqNone ?
                                                                                      operationPrecision :
-                                                                                     type.getQualifier().precision; }
+                                                                                     type->getQualifier().precision; }
     TString getCompleteString() const
     {
-        TString cs = type.getCompleteString();
-        if (getOperationPrecision() != type.getQualifier().precision) {
+        TString cs = type->getCompleteString();
+        if (getOperationPrecision() != type->getQualifier().precision) {
             cs += ", operation at ";
             cs += GetPrecisionQualifierString(getOperationPrecision());
         }
@@ -45,8 +45,11 @@
 #include "SymbolTable.h"
 #include "propagateNoContraction.h"
 
+#include <atomic>
 #include <cfloat>
+#include <cstdlib>
 #include <limits>
+#include <new>
 #include <utility>
 #include <tuple>
 
@@ -2337,7 +2340,9 @@ TIntermTyped* TIntermediate::addComma(TIntermTyped* left, TIntermTyped* right, c
     TIntermTyped *commaAggregate = growAggregate(left, right, loc);
     commaAggregate->getAsAggregate()->setOperator(EOpComma);
     commaAggregate->setType(right->getType());
-    commaAggregate->getWritableType().getQualifier().makeTemporary();
+    TQualifier temporaryQualifier = right->getQualifier();
+    temporaryQualifier.makeTemporary();
+    commaAggregate->setQualifier(temporaryQualifier);
 
     return commaAggregate;
 }
@@ -2429,14 +2434,17 @@ TIntermTyped* TIntermediate::addSelection(TIntermTyped* cond, TIntermTyped* true
     //
     TIntermSelection* node = new TIntermSelection(cond, trueBlock, falseBlock, trueBlock->getType());
     node->setLoc(loc);
-    node->getQualifier().precision = std::max(trueBlock->getQualifier().precision, falseBlock->getQualifier().precision);
+    node->setPrecision(std::max(trueBlock->getQualifier().precision, falseBlock->getQualifier().precision));
 
     if ((cond->getQualifier().isConstant() && specConstantPropagates(*trueBlock, *falseBlock)) ||
         (cond->getQualifier().isSpecConstant() && trueBlock->getQualifier().isConstant() &&
                                                  falseBlock->getQualifier().isConstant()))
-        node->getQualifier().makeSpecConstant();
-    else
-        node->getQualifier().makeTemporary();
+        node->getWritableType().getQualifier().makeSpecConstant();
+    else {
+        TQualifier temporaryQualifier = node->getQualifier();
+        temporaryQualifier.makeTemporary();
+        node->setQualifier(temporaryQualifier);
+    }
 
     if (getSource() == EShSourceHlsl)
         node->setNoShortCircuit();
@@ -2453,7 +2461,7 @@ TIntermTyped* TIntermediate::addSelection(TIntermTyped* cond, TIntermTyped* true
 TIntermConstantUnion* TIntermediate::addConstantUnion(const TConstUnionArray& unionArray, const TType& t, const TSourceLoc& loc, bool literal) const
 {
     TIntermConstantUnion* node = new TIntermConstantUnion(unionArray, t);
-    node->getQualifier().storage = EvqConst;
+    node->setStorage(EvqConst);
     node->setLoc(loc);
     if (literal)
         node->setLiteral();
@@ -3127,7 +3135,9 @@ bool TIntermediate::promoteUnary(TIntermUnary& node)
     }
 
     node.setType(operand->getType());
-    node.getWritableType().getQualifier().makeTemporary();
+    TQualifier temporaryQualifier = operand->getQualifier();
+    temporaryQualifier.makeTemporary();
+    node.setQualifier(temporaryQualifier);
 
     return true;
 }
@@ -3138,7 +3148,7 @@ void TIntermUnary::updatePrecision()
     if (getBasicType() == EbtInt || getBasicType() == EbtUint ||
         getBasicType() == EbtFloat) {
         if (operand->getQualifier().precision > getQualifier().precision)
-            getQualifier().precision = operand->getQualifier().precision;
+            setPrecision(operand->getQualifier().precision);
     }
 }
 
@@ -3159,7 +3169,9 @@ bool TIntermediate::promoteBinary(TIntermBinary& node)
     // Base assumption:  just make the type the same as the left
     // operand.  Only deviations from this will be coded.
     node.setType(left->getType());
-    node.getWritableType().getQualifier().clear();
+    TQualifier clearedQualifier;
+    clearedQualifier.clear();
+    node.setQualifier(clearedQualifier);
 
     // Composite and opaque types don't having pending operator changes, e.g.,
     // array, structure, and samplers.  Just establish final type and correctness.
@@ -3225,7 +3237,7 @@ bool TIntermediate::promoteBinary(TIntermBinary& node)
 
             // Update the original base assumption on result type..
             node.setType(left->getType());
-            node.getWritableType().getQualifier().clear();
+            node.setQualifier(clearedQualifier);
 
             break;
 
@@ -3574,8 +3586,10 @@ bool TIntermediate::promoteBinary(TIntermBinary& node)
         if (left->isVector() && right->isVector() && left->getVectorSize() != right->getVectorSize())
             return false;
         if (right->isVector() || right->isMatrix()) {
-            node.getWritableType().shallowCopy(right->getType());
-            node.getWritableType().getQualifier().makeTemporary();
+            node.setType(right->getType());
+            TQualifier temporaryQualifier = right->getQualifier();
+            temporaryQualifier.makeTemporary();
+            node.setQualifier(temporaryQualifier);
         }
         break;
 
@@ -3692,7 +3706,7 @@ void TIntermAggregate::updatePrecision()
             assert(typedNode);
             maxPrecision = std::max(maxPrecision, typedNode->getQualifier().precision);
         }
-        getQualifier().precision = maxPrecision;
+        setPrecision(maxPrecision);
         for (unsigned int i = 0; i < operands.size(); ++i) {
           TIntermTyped* typedNode = operands[i]->getAsTyped();
           assert(typedNode);
@@ -3709,9 +3723,9 @@ void TIntermBinary::updatePrecision()
          getBasicType() == EbtFloat) {
        if (op == EOpRightShift || op == EOpLeftShift) {
          // For shifts get precision from left side only and thus no need to propagate
-         getQualifier().precision = left->getQualifier().precision;
+         setPrecision(left->getQualifier().precision);
        } else {
-         getQualifier().precision = std::max(right->getQualifier().precision, left->getQualifier().precision);
+         setPrecision(std::max(right->getQualifier().precision, left->getQualifier().precision));
          if (getQualifier().precision != EpqNone) {
            left->propagatePrecision(getQualifier().precision);
            right->propagatePrecision(getQualifier().precision);
@@ -3720,6 +3734,144 @@ void TIntermBinary::updatePrecision()
     }
 }
 
+//
+// Interned types.
+//
+// Plain types are EbtVoid through EbtBool, as scalars, vectors (including HLSL's
+// 1-component vector), or matrices, with no qualification beyond storage and precision.
+// They are indexed directly by basic type, storage, precision, and shape, and created
+// on first use.  Entries live outside any pool so that every thread, pool, and compile
+// can share them.
+//
+namespace {
+
+const int InternedStorageCount = 7;
+const int InternedShapeCount = 5 + 4 * 4;  // scalar, vec2-4, vector1, then 1x1 to 4x4 matrices
+
+std::atomic<const TType*> InternedTypes[EbtBool + 1][InternedStorageCount][EpqHigh + 1][InternedShapeCount];
+
+int InternedStorageIndex(TStorageQualifier storage)
+{
+    switch (storage) {
+    case EvqTemporary:     return 0;
+    case EvqGlobal:        return 1;
+    case EvqConst:         return 2;
+    case EvqIn:            return 3;
+    case EvqOut:           return 4;
+    case EvqInOut:         return 5;
+    case EvqConstReadOnly: return 6;
+    default:               return -1;
+    }
+}
+
+} // end anonymous namespace
+
+const TType* TType::findInterned(const TType& type)
+{
+    if (type.basicType > EbtBool || type.arraySizes != nullptr || type.structure != nullptr ||
+        type.fieldName != nullptr || type.typeName != nullptr || type.typeParameters != nullptr ||
+        type.spirvType != nullptr || type.coopmatNV || type.coopmatKHR || type.coopmatKHRuse != 0 ||
+        type.coopmatKHRUseValid || type.coopvecNV || type.tileAttachmentQCOM)
+        return nullptr;
+
+    TSampler clearedSampler;
+    clearedSampler.clear();
+    if (type.sampler != clearedSampler || ! type.qualifier.hasOnlyStorageAndPrecision())
+        return nullptr;
+
+    const int storage = InternedStorageIndex(type.qualifier.storage);
+    if (storage < 0 || type.qualifier.precision > EpqHigh)
+        return nullptr;
+
+    int shape;
+    if (type.matrixCols == 0) {
+        if (type.matrixRows != 0 || type.vectorSize < 1 || type.vectorSize > 4 ||
+            (type.vector1 && type.vectorSize != 1))
+            return nullptr;
+        shape = type.vector1 ? 4 : type.vectorSize - 1;
+    } else {
+        if (type.vectorSize != 0 || type.vector1 || type.matrixCols > 4 ||
+            type.matrixRows < 1 || type.matrixRows > 4)
+            return nullptr;
+        shape = 5 + (type.matrixCols - 1) * 4 + (type.matrixRows - 1);
+    }
+
+    std::atomic<const TType*>& slot = InternedTypes[type.basicType][storage][type.qualifier.precision][shape];
+    const TType* interned = slot.load(std::memory_order_acquire);
+    if (interned != nullptr)
+        return interned;
+
+    // Zeroed memory, so that bits no TType constructor sets still compare as clear.
+    void* memory = calloc(1, sizeof(TType));
+    if (memory == nullptr)
+        return nullptr;
+    TType* created = new (memory) TType(type.basicType, type.qualifier.storage, type.qualifier.precision,
+                                        type.vectorSize, type.matrixCols, type.matrixRows, type.vector1);
+    if (slot.compare_exchange_strong(interned, created, std::memory_order_acq_rel))
+        return created;
+
+    // another thread created it first
+    created->~TType();
+    free(memory);
+    return interned;
+}
+
+void TIntermTyped::assignType(const TType& t)
+{
+    // once a node owns its type it keeps it, so earlier getWritableType() references stay live
+    if (writableType == nullptr) {
+        const TType* interned = TType::findInterned(t);
+        if (interned != nullptr) {
+            type = interned;
+            return;
+        }
+        writableType = new TType;
+        type = writableType;
+    }
+    writableType->shallowCopy(t);
+}
+
+TType& TIntermTyped::getWritableType()
+{
+    if (writableType == nullptr) {
+        writableType = new TType;
+        writableType->shallowCopy(*type);
+        type = writableType;
+    }
+    return *writableType;
+}
+
+void TIntermTyped::setQualifier(const TQualifier& qualifier)
+{
+    if (writableType != nullptr) {
+        writableType->getQualifier() = qualifier;
+        return;
+    }
+
+    TType changed;
+    changed.shallowCopy(*type);
+    changed.getQualifier() = qualifier;
+    assignType(changed);
+}
+
+void TIntermTyped::setStorage(TStorageQualifier storage)
+{
+    if (type->getQualifier().storage == storage)
+        return;
+    TQualifier qualifier = type->getQualifier();
+    qualifier.storage = storage;
+    setQualifier(qualifier);
+}
+
+void TIntermTyped::setPrecision(TPrecisionQualifier precision)
+{
+    if (type->getQualifier().precision == precision)
+        return;
+    TQualifier qualifier = type->getQualifier();
+    qualifier.precision = precision;
+    setQualifier(qualifier);
+}
+
 // Recursively propagate precision qualifiers *down* the subtree of the current node,
 // until reaching a node that already has a precision qualifier or otherwise does
 // not participate in precision propagation.
@@ -3730,7 +3882,7 @@ void TIntermTyped::propagatePrecision(TPrecisionQualifier newPrecision)
          getBasicType() != EbtFloat && getBasicType() != EbtFloat16))
         return;
 
-    getQualifier().precision = newPrecision;
+    setPrecision(newPrecision);
 
     TIntermBinary* binaryNode = getAsBinaryNode();
     if (binaryNode) {
@@ -0,0 +1,141 @@
+//
+// Copyright (C) 2026 The Shaderc Authors.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of The Shaderc Authors nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+//
+// A read-only table mapping keyword spellings to values, built at compile
+// time, for the scanners' per-identifier keyword and reserved-word lookups.
+//
+// The table is open addressed, at most half full, and probed linearly.  An
+// identifier is hashed in the same pass that finds its length, once for all
+// tables it is looked up in; a mask of the keyword lengths present rejects
+// some non-keywords before any probing, and probing compares the stored hash
+// and length before the characters.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace glslang {
+
+// An identifier, hashed once for lookups in any number of TKeywordTables.
+struct TKeywordText {
+    constexpr explicit TKeywordText(const char* text) : text(text), length(0), hash(2166136261u)
+    {
+        // FNV-1a, finished with a shift so the low bits used for the slot
+        // depend on every character.
+        const char* c = text;
+        for (; *c != 0; ++c)
+            hash = (hash ^ (unsigned char)*c) * 16777619u;
+        length = c - text;
+        hash ^= hash >> 16;
+    }
+    const char* text;
+    size_t length;
+    uint32_t hash;
+};
+
+template<typename T>
+struct TKeywordEntry {
+    constexpr TKeywordEntry(const char* text, T value = T()) : text(text), value(value) { }
+    const char* text;
+    T value;
+};
+
+template<typename T, size_t N>
+class TKeywordTable {
+public:
+    constexpr explicit TKeywordTable(const TKeywordEntry<T> (&entries)[N])
+    {
+        for (size_t e = 0; e < N; ++e) {
+            const TKeywordText key(entries[e].text);
+            lengthMask |= lengthBit(key.length);
+            size_t s = key.hash & (Capacity - 1);
+            for (; slots[s].text != nullptr; s = (s + 1) & (Capacity - 1)) {
+                if (slots[s].hash == key.hash && equal(slots[s].text, key.text))
+                    break;
+            }
+            // Like the maps this replaces, the first of duplicate entries wins.
+            if (slots[s].text == nullptr)
+                slots[s] = { key.text, key.hash, (uint32_t)key.length, entries[e].value };
+        }
+    }
+
+    // Returns the value of keyword 'key', or nullptr if it is not one.
+    const T* find(const TKeywordText& key) const
+    {
+        if ((lengthMask & lengthBit(key.length)) == 0)
+            return nullptr;
+        for (size_t s = key.hash & (Capacity - 1); slots[s].text != nullptr; s = (s + 1) & (Capacity - 1)) {
+            if (slots[s].hash == key.hash && slots[s].length == key.length &&
+                memcmp(slots[s].text, key.text, key.length) == 0)
+                return &slots[s].value;
+        }
+        return nullptr;
+    }
+    const T* find(const char* text) const { return find(TKeywordText(text)); }
+    bool contains(const TKeywordText& key) const { return find(key) != nullptr; }
+
+protected:
+    // The smallest power of two at least twice N.
+    static constexpr size_t capacityFor(size_t n)
+    {
+        size_t capacity = 1;
+        while (capacity < 2 * n)
+            capacity *= 2;
+        return capacity;
+    }
+    static constexpr size_t Capacity = capacityFor(N);
+
+    static constexpr uint64_t lengthBit(size_t length) { return uint64_t(1) << (length < 63 ? length : 63); }
+    static constexpr bool equal(const char* a, const char* b)
+    {
+        for (; *a != 0 && *a == *b; ++a, ++b)
+            ;
+        return *a == *b;
+    }
+
+    struct Slot {
+        const char* text;
+        uint32_t hash;
+        uint32_t length;
+        T value;
+    };
+    Slot slots[Capacity] = {};
+    uint64_t lengthMask = 0;
+};
+
+} // end namespace glslang
@@ -1789,9 +1789,9 @@ TIntermTyped* TParseContext::handleBuiltInFunctionCall(TSourceLoc loc, TIntermNo
             auto& sequence = agg->getSequence();
             for (unsigned i = 0; i < sequence.size(); ++i) {
                 if (function[i].type->getQualifier().isSpirvByReference())
-                    sequence[i]->getAsTyped()->getQualifier().setSpirvByReference();
+                    sequence[i]->getAsTyped()->getWritableType().getQualifier().setSpirvByReference();
                 if (function[i].type->getQualifier().isSpirvLiteral())
-                    sequence[i]->getAsTyped()->getQualifier().setSpirvLiteral();
+                    sequence[i]->getAsTyped()->getWritableType().getQualifier().setSpirvLiteral();
             }
 
             // Attach the function call to SPIR-V intruction
@@ -1799,9 +1799,9 @@ TIntermTyped* TParseContext::handleBuiltInFunctionCall(TSourceLoc loc, TIntermNo
         } else if (auto unaryNode = result->getAsUnaryNode()) {
             // Propogate spirv_by_reference/spirv_literal from parameters to arguments
             if (function[0].type->getQualifier().isSpirvByReference())
-                unaryNode->getOperand()->getQualifier().setSpirvByReference();
+                unaryNode->getOperand()->getWritableType().getQualifier().setSpirvByReference();
             if (function[0].type->getQualifier().isSpirvLiteral())
-                unaryNode->getOperand()->getQualifier().setSpirvLiteral();
+                unaryNode->getOperand()->getWritableType().getQualifier().setSpirvLiteral();
 
             // Attach the function call to SPIR-V intruction
             unaryNode->setSpirvInstruction(function.getSpirvInstruction());
@@ -1902,13 +1902,13 @@ void TParseContext::computeBuiltinPrecisions(TIntermTyped& node, const TFunction
 
     // Propagate precision through this node and its children. That algorithm stops
     // when a precision is found, so start by clearing this subroot precision
-    opNode->getQualifier().precision = EpqNone;
+    opNode->setPrecision(EpqNone);
     if (operationPrecision != EpqNone) {
         opNode->propagatePrecision(operationPrecision);
         opNode->setOperationPrecision(operationPrecision);
     }
     // Now, set the result precision, which might not match
-    opNode->getQualifier().precision = resultPrecision;
+    opNode->setPrecision(resultPrecision);
 }
 
 TIntermNode* TParseContext::handleReturnValue(const TSourceLoc& loc, TIntermTyped* value)
@@ -3238,7 +3238,7 @@ void TParseContext::nonOpBuiltInCheck(const TSourceLoc& loc, const TFunction& fn
     // built-in texturing functions get their return value precision from the precision of the sampler
     if (fnCandidate.getType().getQualifier().precision == EpqNone &&
         fnCandidate.getParamCount() > 0 && fnCandidate[0].type->getBasicType() == EbtSampler)
-        callNode.getQualifier().precision = callNode.getSequence()[0]->getAsTyped()->getQualifier().precision;
+        callNode.setPrecision(callNode.getSequence()[0]->getAsTyped()->getQualifier().precision);
 
     if (fnCandidate.getName().compare(0, 7, "texture") == 0) {
         if (fnCandidate.getName().compare(0, 13, "textureGather") == 0) {
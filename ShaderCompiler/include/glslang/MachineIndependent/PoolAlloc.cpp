@@ -35,6 +35,10 @@
 #include "../Include/Common.h"
 #include "../Include/PoolAlloc.h"
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 // Mostly here for target that do not support threads such as WASI.
 #ifdef DISABLE_THREAD_SUPPORT
 #define THREAD_LOCAL 
@@ -46,12 +50,94 @@ namespace glslang {
 
 namespace {
 THREAD_LOCAL TPoolAllocator* threadPoolAllocator = nullptr;
+THREAD_LOCAL TPoolAllocatorOptions threadPoolAllocatorOptions;
 
 TPoolAllocator* GetDefaultThreadPoolAllocator()
 {
     THREAD_LOCAL TPoolAllocator defaultAllocator;
     return &defaultAllocator;
 }
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+const size_t hugePageSize = 2*1024*1024;
+
+// Maps 'size' bytes, a multiple of hugePageSize, aligned so the OS can back
+// them with huge pages.
+void* MapHugePages(size_t size)
+{
+    void* mapping = mmap(nullptr, size + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+        return nullptr;
+
+    // Trim the mapping down to an aligned 'size' bytes.
+    UINT_PTR start = reinterpret_cast<UINT_PTR>(mapping);
+    UINT_PTR aligned = (start + hugePageSize - 1) & ~(UINT_PTR)(hugePageSize - 1);
+    if (aligned != start)
+        munmap(mapping, aligned - start);
+    if (aligned + size != start + size + hugePageSize)
+        munmap(reinterpret_cast<void*>(aligned + size), start + hugePageSize - aligned);
+
+    madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+    return reinterpret_cast<void*>(aligned);
+}
+
+void UnmapHugePages(void* memory, size_t size)
+{
+    munmap(memory, size);
+}
+#else
+const size_t hugePageSize = 0;
+
+void* MapHugePages(size_t) { return nullptr; }
+void UnmapHugePages(void*, size_t) { }
+#endif
+
+// Memory left behind by destroyed pools, for the next pool on this thread with
+// the same kind of page.  Single pages and multi-page allocations are kept on
+// separate lists, linked through their first bytes.
+struct TRecycledPages {
+    struct tBlock {
+        tBlock* next;
+        size_t pageCount;
+    };
+
+    ~TRecycledPages() { clear(0, false); }
+
+    // Drop everything if it is not of the given kind.
+    void clear(size_t newPageSize, bool newHugePages)
+    {
+        if (newPageSize == pageSize && newHugePages == hugePages)
+            return;
+        while (pages != nullptr) {
+            tBlock* next = pages->next;
+            if (hugePages)
+                UnmapHugePages(pages, pageSize);
+            else
+                delete [] reinterpret_cast<char*>(pages);
+            pages = next;
+        }
+        while (multiPages != nullptr) {
+            tBlock* next = multiPages->next;
+            delete [] reinterpret_cast<char*>(multiPages);
+            multiPages = next;
+        }
+        bytes = 0;
+        pageSize = newPageSize;
+        hugePages = newHugePages;
+    }
+
+    tBlock* pages = nullptr;
+    tBlock* multiPages = nullptr;
+    size_t bytes = 0;
+    size_t pageSize = 0;
+    bool hugePages = false;
+};
+
+TRecycledPages& GetRecycledPages()
+{
+    THREAD_LOCAL TRecycledPages recycledPages;
+    return recycledPages;
+}
 } // anonymous namespace
 
 // Return the thread-specific current pool.
@@ -66,17 +152,53 @@ void SetThreadPoolAllocator(TPoolAllocator* poolAllocator)
     threadPoolAllocator = poolAllocator;
 }
 
+// Return the thread-specific options for new shader and program pools.
+const TPoolAllocatorOptions& GetThreadPoolAllocatorOptions()
+{
+    return threadPoolAllocatorOptions;
+}
+
+// Set the thread-specific options for new shader and program pools.
+void SetThreadPoolAllocatorOptions(const TPoolAllocatorOptions& options)
+{
+    threadPoolAllocatorOptions = options;
+}
+
 //
 // Implement the functionality of the TPoolAllocator class, which
 // is documented in PoolAlloc.h.
 //
 TPoolAllocator::TPoolAllocator(int growthIncrement, int allocationAlignment) :
     pageSize(growthIncrement),
-    alignment(allocationAlignment),
     freeList(nullptr),
     inUseList(nullptr),
-    numCalls(0)
+    hugePages(false),
+    recycleBytes(0)
 {
+    initialize(allocationAlignment);
+}
+
+TPoolAllocator::TPoolAllocator(const TPoolAllocatorOptions& options, int allocationAlignment) :
+    pageSize(options.pageSize),
+    freeList(nullptr),
+    inUseList(nullptr),
+    hugePages(options.hugePages && hugePageSize != 0),
+    recycleBytes(options.recycleBytes)
+{
+    if (hugePages)
+        pageSize = (pageSize + hugePageSize - 1) & ~(hugePageSize - 1);
+
+    initialize(allocationAlignment);
+}
+
+void TPoolAllocator::initialize(int allocationAlignment)
+{
+    alignment = allocationAlignment;
+    numCalls = 0;
+    totalBytes = 0;
+    systemAllocations = 0;
+    systemBytes = 0;
+
     //
     // Don't allow page sizes we know are smaller than all common
     // OS page sizes.
@@ -119,13 +241,14 @@ TPoolAllocator::~TPoolAllocator()
 {
     while (inUseList) {
         tHeader* next = inUseList->nextPage;
+        size_t pageCount = inUseList->pageCount;
         inUseList->~tHeader();
-        delete [] reinterpret_cast<char*>(inUseList);
+        releasePages(inUseList, pageCount);
         inUseList = next;
     }
 
     //
-    // Always delete the free list memory - it can't be being
+    // Always release the free list memory - it can't be being
     // (correctly) referenced, whether the pool allocator was
     // global or not.  We should not check the guard blocks
     // here, because we did it already when the block was
@@ -133,11 +256,76 @@ TPoolAllocator::~TPoolAllocator()
     //
     while (freeList) {
         tHeader* next = freeList->nextPage;
-        delete [] reinterpret_cast<char*>(freeList);
+        releasePages(freeList, 1);
         freeList = next;
     }
 }
 
+//
+// Get 'pageCount' pages, from the thread's recycled memory if it has some of
+// the right kind, otherwise from the OS.  A multi-page allocation may be given
+// a larger recycled block, in which case 'pageCount' is updated to its size.
+//
+TPoolAllocator::tHeader* TPoolAllocator::newPages(size_t& pageCount)
+{
+    if (recycleBytes > 0) {
+        TRecycledPages& recycled = GetRecycledPages();
+        if (recycled.pageSize == pageSize && recycled.hugePages == hugePages) {
+            // Take a single page, or the smallest multi-page block that fits.
+            TRecycledPages::tBlock** best = nullptr;
+            if (pageCount == 1) {
+                if (recycled.pages != nullptr)
+                    best = &recycled.pages;
+            } else {
+                for (TRecycledPages::tBlock** block = &recycled.multiPages; *block != nullptr; block = &(*block)->next) {
+                    if ((*block)->pageCount >= pageCount && (best == nullptr || (*block)->pageCount < (*best)->pageCount))
+                        best = block;
+                }
+            }
+            if (best != nullptr) {
+                TRecycledPages::tBlock* block = *best;
+                *best = block->next;
+                if (pageCount > 1)
+                    pageCount = block->pageCount;
+                recycled.bytes -= pageCount * pageSize;
+                return reinterpret_cast<tHeader*>(block);
+            }
+        }
+    }
+
+    ++systemAllocations;
+    systemBytes += pageCount * pageSize;
+    if (pageCount == 1 && hugePages)
+        return reinterpret_cast<tHeader*>(MapHugePages(pageSize));
+    return reinterpret_cast<tHeader*>(::new char[pageCount * pageSize]);
+}
+
+//
+// Give back 'pageCount' pages from newPages(), keeping them for the thread's
+// next pool if there is room.
+//
+void TPoolAllocator::releasePages(tHeader* pages, size_t pageCount)
+{
+    if (recycleBytes > 0) {
+        TRecycledPages& recycled = GetRecycledPages();
+        recycled.clear(pageSize, hugePages);
+        if (recycled.bytes + pageCount * pageSize <= recycleBytes) {
+            TRecycledPages::tBlock* block = reinterpret_cast<TRecycledPages::tBlock*>(pages);
+            TRecycledPages::tBlock*& list = pageCount == 1 ? recycled.pages : recycled.multiPages;
+            block->next = list;
+            block->pageCount = pageCount;
+            list = block;
+            recycled.bytes += pageCount * pageSize;
+            return;
+        }
+    }
+
+    if (pageCount == 1 && hugePages)
+        UnmapHugePages(pages, pageSize);
+    else
+        delete [] reinterpret_cast<char*>(pages);
+}
+
 //
 // Check a single guard block for damage
 //
@@ -200,7 +388,7 @@ void TPoolAllocator::pop()
         inUseList->~tHeader(); // currently, just a debug allocation checker
 
         if (pageCount > 1) {
-            delete [] reinterpret_cast<char*>(inUseList);
+            releasePages(inUseList, pageCount);
         } else {
             inUseList->nextPage = freeList;
             freeList = inUseList;
@@ -257,12 +445,13 @@ void* TPoolAllocator::allocate(size_t numBytes)
         // The OS is efficient and allocating and free-ing multiple pages.
         //
         size_t numBytesToAlloc = allocationSize + headerSkip;
-        tHeader* memory = reinterpret_cast<tHeader*>(::new char[numBytesToAlloc]);
+        size_t pageCount = (numBytesToAlloc + pageSize - 1) / pageSize;
+        tHeader* memory = newPages(pageCount);
         if (memory == nullptr)
             return nullptr;
 
         // Use placement-new to initialize header
-        new(memory) tHeader(inUseList, (numBytesToAlloc + pageSize - 1) / pageSize);
+        new(memory) tHeader(inUseList, pageCount);
         inUseList = memory;
 
         currentPageOffset = pageSize;  // make next allocation come from a new page
@@ -279,7 +468,8 @@ void* TPoolAllocator::allocate(size_t numBytes)
         memory = freeList;
         freeList = freeList->nextPage;
     } else {
-        memory = reinterpret_cast<tHeader*>(::new char[pageSize]);
+        size_t pageCount = 1;
+        memory = newPages(pageCount);
         if (memory == nullptr)
             return nullptr;
     }
@@ -42,8 +42,11 @@
 //
 
 #include <cstring>
-#include <unordered_map>
-#include <unordered_set>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GLSLANG_SCAN_SSE2
+#endif
 
 #include "../Include/Types.h"
 #include "SymbolTable.h"
@@ -51,6 +54,7 @@
 #include "attribute.h"
 #include "glslang_tab.cpp.h"
 #include "ScanContext.h"
+#include "KeywordTable.h"
 #include "Scan.h"
 
 // preprocessor includes
@@ -60,6 +64,78 @@
 // Required to avoid missing prototype warnings for some compilers
 int yylex(YYSTYPE*, glslang::TParseContext&);
 
+namespace {
+
+using glslang::TInputScanner;
+
+// Whether 'c' is in the class of characters 'RunClass'.
+template<TInputScanner::TRunClass RunClass>
+inline bool inRunClass(unsigned char c)
+{
+    switch (RunClass) {
+    case TInputScanner::ERunSpaceTab:     return c == ' ' || c == '\t';
+    case TInputScanner::ERunLineComment:  return c != '\n' && c != '\r' && c != '\\';
+    case TInputScanner::ERunBlockComment: return c != '*' && c != '\\';
+    case TInputScanner::ERunIdentifier:
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+    return false;
+}
+
+#ifdef GLSLANG_SCAN_SSE2
+// A mask with bit i set if byte i of 'block' is in the class 'RunClass'.
+template<TInputScanner::TRunClass RunClass>
+inline int runClassMask(__m128i block)
+{
+    const auto is = [block](char c) { return _mm_cmpeq_epi8(block, _mm_set1_epi8(c)); };
+    switch (RunClass) {
+    case TInputScanner::ERunSpaceTab:
+        return _mm_movemask_epi8(_mm_or_si128(is(' '), is('\t')));
+    case TInputScanner::ERunLineComment:
+        return ~_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(is('\n'), is('\r')), is('\\'))) & 0xFFFF;
+    case TInputScanner::ERunBlockComment:
+        return ~_mm_movemask_epi8(_mm_or_si128(is('*'), is('\\'))) & 0xFFFF;
+    case TInputScanner::ERunIdentifier:
+    {
+        // Signed compares, so bytes of 0x80 and up are never in range.
+        const auto inRange = [](__m128i b, char first, char last) {
+            return _mm_and_si128(_mm_cmpgt_epi8(b, _mm_set1_epi8(first - 1)),
+                                 _mm_cmplt_epi8(b, _mm_set1_epi8(last + 1)));
+        };
+        const __m128i letter = inRange(_mm_or_si128(block, _mm_set1_epi8(0x20)), 'a', 'z');
+        const __m128i digit = inRange(block, '0', '9');
+        return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), is('_')));
+    }
+    }
+    return 0;
+}
+#endif
+
+// The length of the run of characters of class 'RunClass' starting 'text',
+// which has 'length' characters.
+template<TInputScanner::TRunClass RunClass>
+size_t runLength(const unsigned char* text, size_t length)
+{
+    size_t i = 0;
+#ifdef GLSLANG_SCAN_SSE2
+    for (; i + 16 <= length; i += 16) {
+        int outside = ~runClassMask<RunClass>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i))) & 0xFFFF;
+        if (outside != 0) {
+            while ((outside & 1) == 0) {
+                outside >>= 1;
+                ++i;
+            }
+            return i;
+        }
+    }
+#endif
+    while (i < length && inRunClass<RunClass>(text[i]))
+        ++i;
+    return i;
+}
+
+} // end anonymous namespace
+
 namespace glslang {
 
 // read past any white space
@@ -88,8 +164,10 @@ bool TInputScanner::consumeComment()
         get();  // consume the second '/'
         c = get();
         do {
-            while (c != EndOfInput && c != '\\' && c != '\r' && c != '\n')
+            while (c != EndOfInput && c != '\\' && c != '\r' && c != '\n') {
+                consumeRun(ERunLineComment);
                 c = get();
+            }
 
             if (c == EndOfInput || c == '\r' || c == '\n') {
                 while (c == '\r' || c == '\n')
@@ -121,8 +199,10 @@ bool TInputScanner::consumeComment()
         get();  // consume the '*'
         c = get();
         do {
-            while (c != EndOfInput && c != '*')
+            while (c != EndOfInput && c != '*') {
+                consumeRun(ERunBlockComment);
                 c = get();
+            }
             if (c == '*') {
                 c = get();
                 if (c == '/')
@@ -160,6 +240,54 @@ void TInputScanner::consumeWhitespaceComment(bool& foundNonSpaceTab)
     } while (true);
 }
 
+size_t TInputScanner::consumeRun(TRunClass runClass, char* text, size_t maxLength)
+{
+    if (currentSource >= numSources || currentChar + 1 >= lengths[currentSource])
+        return 0;
+
+    const unsigned char* start = sources[currentSource] + currentChar;
+    size_t available = lengths[currentSource] - currentChar - 1;
+    if (text != nullptr && available > maxLength)
+        available = maxLength;
+
+    size_t length = 0;
+    switch (runClass) {
+    case ERunSpaceTab:     length = runLength<ERunSpaceTab>(start, available);     break;
+    case ERunLineComment:  length = runLength<ERunLineComment>(start, available);  break;
+    case ERunBlockComment: length = runLength<ERunBlockComment>(start, available); break;
+    case ERunIdentifier:   length = runLength<ERunIdentifier>(start, available);   break;
+    }
+    if (length == 0)
+        return 0;
+
+    if (text != nullptr)
+        memcpy(text, start, length);
+    currentChar += length;
+
+    // Only block comments can hold newlines; update the location as get() would.
+    int newLines = 0;
+    size_t lineStart = 0;
+    if (runClass == ERunBlockComment) {
+        for (size_t c = 0; c < length; ++c) {
+            if (start[c] == '\n') {
+                ++newLines;
+                lineStart = c + 1;
+            }
+        }
+    }
+    if (newLines == 0) {
+        loc[currentSource].column += (int)length;
+        logicalSourceLoc.column += (int)length;
+    } else {
+        loc[currentSource].line += newLines;
+        logicalSourceLoc.line += newLines;
+        loc[currentSource].column = (int)(length - lineStart);
+        logicalSourceLoc.column = (int)(length - lineStart);
+    }
+
+    return length;
+}
+
 // Returns true if there was non-white space (e.g., a comment, newline) before the #version
 // or no #version was found; otherwise, returns false.  There is no error case, it always
 // succeeds, but will leave version == 0 if no #version was found.
@@ -298,31 +426,8 @@ int yylex(YYSTYPE* glslangTokenDesc, glslang::TParseContext& parseContext)
 
 namespace {
 
-struct str_eq
-{
-    bool operator()(const char* lhs, const char* rhs) const
-    {
-        return strcmp(lhs, rhs) == 0;
-    }
-};
-
-struct str_hash
-{
-    size_t operator()(const char* str) const
-    {
-        // djb2
-        unsigned long hash = 5381;
-        int c;
-
-        while ((c = *str++) != 0)
-            hash = ((hash << 5) + hash) + c;
-
-        return hash;
-    }
-};
-
 // A single global usable by all threads, by all versions, by all languages.
-const std::unordered_map<const char*, int, str_hash, str_eq> KeywordMap {
+constexpr glslang::TKeywordEntry<int> KeywordList[] = {
     {"const",CONST},
     {"uniform",UNIFORM},
     {"tileImageEXT",TILEIMAGEEXT},
@@ -775,7 +880,9 @@ const std::unordered_map<const char*, int, str_hash, str_eq> KeywordMap {
 
     {"coopvecNV",COOPVECNV},
 };
-const std::unordered_set<const char*, str_hash, str_eq> ReservedSet {
+constexpr glslang::TKeywordTable KeywordMap(KeywordList);
+
+constexpr glslang::TKeywordEntry<bool> ReservedList[] = {
     "common",
     "partition",
     "active",
@@ -814,6 +921,7 @@ const std::unordered_set<const char*, str_hash, str_eq> ReservedSet {
     "namespace",
     "using",
 };
+constexpr glslang::TKeywordTable ReservedSet(ReservedList);
 
 }
 
@@ -924,15 +1032,16 @@ int TScanContext::tokenize(TPpContext* pp, TParserToken& token)
 
 int TScanContext::tokenizeIdentifier()
 {
-    if (ReservedSet.find(tokenText) != ReservedSet.end())
+    const TKeywordText text(tokenText);
+    if (ReservedSet.contains(text))
         return reservedWord();
 
-    auto it = KeywordMap.find(tokenText);
-    if (it == KeywordMap.end()) {
+    const int* it = KeywordMap.find(text);
+    if (it == nullptr) {
         // Should have an identifier of some sort
         return identifierOrType();
     }
-    keyword = it->second;
+    keyword = *it;
 
     switch (keyword) {
     case CONST:
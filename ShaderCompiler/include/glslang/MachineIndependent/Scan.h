@@ -223,6 +223,22 @@ public:
     void consumeWhitespaceComment(bool& foundNonSpaceTab);
     bool scanVersion(int& version, EProfile& profile, bool& notFirstToken);
 
+    // Classes of characters that consumeRun() can consume in bulk.
+    enum TRunClass {
+        ERunSpaceTab,       // ' ' and '\t'
+        ERunLineComment,    // anything but '\n', '\r' and '\\'
+        ERunBlockComment,   // anything but '*' and '\\'
+        ERunIdentifier,     // letters, digits and '_'
+    };
+
+    // Consume the run of characters of class 'runClass' at the cursor, with the
+    // same effect as that many calls to get().  The run never includes the last
+    // character of the current string, so it never moves on to the next string;
+    // callers go on with get() either way.  If 'text' is not null, the run is
+    // also copied to it, and is at most 'maxLength' characters long.
+    // Returns the number of characters consumed.
+    size_t consumeRun(TRunClass runClass, char* text = nullptr, size_t maxLength = 0);
+
 protected:
 
     // advance one character
@@ -44,8 +44,12 @@
 #include <cstring>
 #include <iostream>
 #include <sstream>
+#include <map>
 #include <memory>
 #include <mutex>
+#ifndef DISABLE_THREAD_SUPPORT
+#include <atomic>
+#endif
 #include "SymbolTable.h"
 #include "ParseHelper.h"
 #include "Scan.h"
@@ -75,6 +79,19 @@
 // Build-time generated includes
 #include "glslang/build_info.h"
 
+namespace glslang {
+
+// Macro sets built from a precompiled preamble's header set, one per key built
+// by InstallPrecompiledPreamble().
+struct TPrecompiledPreamble::TMacroSets {
+#ifndef DISABLE_THREAD_SUPPORT
+    std::mutex lock;
+#endif
+    std::map<std::string, std::shared_ptr<const TPpMacroSet>> sets;
+};
+
+} // end namespace glslang
+
 namespace { // anonymous namespace for file-local functions and symbols
 
 // Total number of successful initializers of glslang: a refcount
@@ -241,6 +258,19 @@ TSymbolTable* SharedSymbolTables[VersionCount][SpvVersionCount][ProfileCount][So
 
 TPoolAllocator* PerProcessGPA = nullptr;
 
+#ifndef DISABLE_THREAD_SUPPORT
+// Bumped every time the shared tables above are freed.  Each thread remembers
+// which tables it has already seen built, tagged with this generation, so it
+// can skip init_lock on later compiles until the tables are torn down.
+std::atomic<unsigned int> SymbolTableGeneration(0);
+
+struct TKnownSymbolTables {
+    unsigned int generation = 0;
+    bool built[VersionCount][SpvVersionCount][ProfileCount][SourceCount] = {};
+};
+thread_local TKnownSymbolTables KnownSymbolTables;
+#endif
+
 //
 // Parse and add to the given symbol table the content of the given shader string.
 //
@@ -414,12 +444,17 @@ bool AddContextSpecificSymbols(const TBuiltInResource* resources, TInfoSink& inf
 //
 // To do this on the fly, we want to leave the current state of our thread's
 // pool allocator intact, so:
-//  - Switch to a new pool for parsing the built-ins
-//  - Do the parsing, which builds the symbol table, using the new pool
-//  - Switch to the process-global pool to save a copy of the resulting symbol table
-//  - Free up the new pool used to parse the built-ins
+//  - Switch to the process-global pool for parsing the built-ins
+//  - Do the parsing, which builds the symbol tables directly in that pool
+//  - Make the resulting tables read-only and publish them as the global tables
 //  - Switch back to the original thread's pool
 //
+// Parsing straight into the process-global pool means the tables never have to
+// be cloned out of a scratch pool, which used to cost about a third as much as
+// parsing them.  The price is that parse-time garbage stays in the global pool
+// until ShFinalize(), but that is about the size of the copy it replaces, and
+// peak memory is lower since the scratch pool and the copy never coexist.
+//
 // This only gets done the first time any thread needs a particular symbol table
 // (lazy evaluation).
 //
@@ -428,26 +463,39 @@ bool SetupBuiltinSymbolTable(int version, EProfile profile, const SpvVersion& sp
     TInfoSink infoSink;
     bool success;
 
-    // Make sure only one thread tries to do this at a time
+    int versionIndex = MapVersionToIndex(version);
+    int spvVersionIndex = MapSpvVersionToIndex(spvVersion);
+    int profileIndex = MapProfileToIndex(profile);
+    int sourceIndex = MapSourceToIndex(source);
+
 #ifndef DISABLE_THREAD_SUPPORT
+    // Fast path: this thread already saw these tables built, and nothing has
+    // freed them since, so there is no need to serialize on init_lock.
+    TKnownSymbolTables& known = KnownSymbolTables;
+    if (known.generation != SymbolTableGeneration.load(std::memory_order_acquire)) {
+        known = TKnownSymbolTables();
+        known.generation = SymbolTableGeneration.load(std::memory_order_acquire);
+    }
+    if (known.built[versionIndex][spvVersionIndex][profileIndex][sourceIndex])
+        return true;
+
+    // Make sure only one thread tries to do this at a time
     const std::lock_guard<std::mutex> lock(init_lock);
 #endif
 
     // See if it's already been done for this version/profile combination
-    int versionIndex = MapVersionToIndex(version);
-    int spvVersionIndex = MapSpvVersionToIndex(spvVersion);
-    int profileIndex = MapProfileToIndex(profile);
-    int sourceIndex = MapSourceToIndex(source);
     if (CommonSymbolTable[versionIndex][spvVersionIndex][profileIndex][sourceIndex][EPcGeneral]) {
+#ifndef DISABLE_THREAD_SUPPORT
+        known.built[versionIndex][spvVersionIndex][profileIndex][sourceIndex] = true;
+#endif
         return true;
     }
 
-    // Switch to a new pool
+    // Switch to the process-global pool; init_lock makes this thread its only user
     TPoolAllocator& previousAllocator = GetThreadPoolAllocator();
-    TPoolAllocator* builtInPoolAllocator = new TPoolAllocator;
-    SetThreadPoolAllocator(builtInPoolAllocator);
+    SetThreadPoolAllocator(PerProcessGPA);
 
-    // Dynamically allocate the local symbol tables so we can control when they are deallocated WRT when the pool is popped.
+    // Dynamically allocate the symbol tables so they can be handed over to the global tables.
     TSymbolTable* commonTable[EPcCount];
     TSymbolTable* stageTables[EShLangCount];
     for (int precClass = 0; precClass < EPcCount; ++precClass)
@@ -455,42 +503,30 @@ bool SetupBuiltinSymbolTable(int version, EProfile profile, const SpvVersion& sp
     for (int stage = 0; stage < EShLangCount; ++stage)
         stageTables[stage] = new TSymbolTable;
 
-    // Generate the local symbol tables using the new pool
-    if (!InitializeSymbolTables(infoSink, commonTable, stageTables, version, profile, spvVersion, source)) {
-        success = false;
-        goto cleanup;
-    }
-
-    // Switch to the process-global pool
-    SetThreadPoolAllocator(PerProcessGPA);
+    success = InitializeSymbolTables(infoSink, commonTable, stageTables, version, profile, spvVersion, source);
 
-    // Copy the local symbol tables from the new pool to the global tables using the process-global pool
-    for (int precClass = 0; precClass < EPcCount; ++precClass) {
-        if (! commonTable[precClass]->isEmpty()) {
-            CommonSymbolTable[versionIndex][spvVersionIndex][profileIndex][sourceIndex][precClass] = new TSymbolTable;
-            CommonSymbolTable[versionIndex][spvVersionIndex][profileIndex][sourceIndex][precClass]->copyTable(*commonTable[precClass]);
-            CommonSymbolTable[versionIndex][spvVersionIndex][profileIndex][sourceIndex][precClass]->readOnly();
-        }
-    }
+    // Publish the non-empty tables, and free the rest.  Stage tables share the common
+    // tables' levels, so they must not be made read-only until every stage has been
+    // initialized.
     for (int stage = 0; stage < EShLangCount; ++stage) {
-        if (! stageTables[stage]->isEmpty()) {
-            SharedSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex][stage] = new TSymbolTable;
-            SharedSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex][stage]->adoptLevels(*CommonSymbolTable
-                              [versionIndex][spvVersionIndex][profileIndex][sourceIndex][CommonIndex(profile, (EShLanguage)stage)]);
-            SharedSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex][stage]->copyTable(*stageTables[stage]);
-            SharedSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex][stage]->readOnly();
-        }
+        if (success && ! stageTables[stage]->isEmpty()) {
+            stageTables[stage]->readOnly();
+            SharedSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex][stage] = stageTables[stage];
+        } else
+            delete stageTables[stage];
     }
-    success = true;
-
-cleanup:
-    // Clean up the local tables before deleting the pool they used.
-    for (int precClass = 0; precClass < EPcCount; ++precClass)
-        delete commonTable[precClass];
-    for (int stage = 0; stage < EShLangCount; ++stage)
-        delete stageTables[stage];
+    for (int precClass = 0; precClass < EPcCount; ++precClass) {
+        if (success && ! commonTable[precClass]->isEmpty()) {
+            commonTable[precClass]->readOnly();
+            CommonSymbolTable[versionIndex][spvVersionIndex][profileIndex][sourceIndex][precClass] = commonTable[precClass];
+        } else
+            delete commonTable[precClass];
+    }
+#ifndef DISABLE_THREAD_SUPPORT
+    if (success)
+        known.built[versionIndex][spvVersionIndex][profileIndex][sourceIndex] = true;
+#endif
 
-    delete builtInPoolAllocator;
     SetThreadPoolAllocator(&previousAllocator);
 
     return success;
@@ -783,6 +819,63 @@ void RecordProcesses(TIntermediate& intermediate, EShMessages messages, const st
     }
 }
 
+// Start 'ppContext' off with the macros of 'precompiledPreamble', preprocessing
+// its header set first unless that was already done under the same source
+// language, version, profile, and built-in macros.
+bool InstallPrecompiledPreamble(TPrecompiledPreamble& precompiledPreamble, const std::string& builtInPreamble,
+                                TParseContextBase& parseContext, TPpContext& ppContext,
+                                TShader::Includer& includer, int version, EProfile profile, EShSource source)
+{
+    const std::string key = std::to_string(source) + ' ' + std::to_string(version) + ' ' +
+                            std::to_string(profile) + '\n' + builtInPreamble;
+    TPrecompiledPreamble::TMacroSets& macroSets = precompiledPreamble.getMacroSets();
+    std::shared_ptr<const TPpMacroSet> macroSet;
+    {
+#ifndef DISABLE_THREAD_SUPPORT
+        const std::lock_guard<std::mutex> lock(macroSets.lock);
+#endif
+        auto it = macroSets.sets.find(key);
+        if (it != macroSets.sets.end())
+            macroSet = it->second;
+    }
+
+    if (! macroSet) {
+        // Preprocess the header set in a context of its own, after the built-in
+        // macros so that those are not captured along with the header's.
+        std::shared_ptr<TPpMacroSet> built(new TPpMacroSet);
+        TInputScanner* previousScanner = parseContext.getScanner();
+        TPpContext builder(parseContext, precompiledPreamble.getName(), includer);
+        TPpToken ppToken;
+
+        const char* builtInString = builtInPreamble.c_str();
+        size_t builtInLength = builtInPreamble.size();
+        TInputScanner builtIns(1, &builtInString, &builtInLength, nullptr, 1);
+        parseContext.setScanner(&builtIns);
+        builder.setInput(builtIns, false);
+        builder.tokenize(ppToken);
+
+        const char* text = precompiledPreamble.getText().c_str();
+        size_t length = precompiledPreamble.getText().size();
+        const char* name = precompiledPreamble.getName().c_str();
+        TInputScanner headers(1, &text, &length, &name);
+        parseContext.setScanner(&headers);
+        builder.setInput(headers, false);
+        const bool success = builder.captureMacros(*built);
+        parseContext.setScanner(previousScanner);
+        if (! success)
+            return false;
+
+        // Another thread may have built the same set meanwhile; keep the first.
+#ifndef DISABLE_THREAD_SUPPORT
+        const std::lock_guard<std::mutex> lock(macroSets.lock);
+#endif
+        macroSet = macroSets.sets.insert(std::make_pair(key, std::move(built))).first->second;
+    }
+
+    ppContext.installMacros(*macroSet);
+    return true;
+}
+
 // This is the common setup and cleanup code for PreprocessDeferred and
 // CompileDeferred.
 // It takes any callable with a signature of
@@ -816,7 +909,8 @@ bool ProcessDeferred(
     TShader::Includer& includer,
     const std::string sourceEntryPointName = "",
     const TEnvironment* environment = nullptr,  // optional way of fully setting all versions, overriding the above
-    bool compileOnly = false)
+    bool compileOnly = false,
+    TPrecompiledPreamble* precompiledPreamble = nullptr)
 {
     // This must be undone (.pop()) by the caller, after it finishes consuming the created tree.
     GetThreadPoolAllocator().push();
@@ -987,6 +1081,10 @@ bool ProcessDeferred(
     // Fill in the strings as outlined above.
     std::string preamble;
     parseContext->getPreamble(preamble);
+    if (precompiledPreamble != nullptr &&
+        ! InstallPrecompiledPreamble(*precompiledPreamble, preamble, *parseContext, ppContext, includer,
+                                     version, profile, source))
+        return false;
     strings[0] = preamble.c_str();
     lengths[0] = strlen(strings[0]);
     names[0] = nullptr;
@@ -1082,7 +1180,11 @@ private:
 //
 // This is not an officially supported or fully working path.
 struct DoPreprocessing {
-    explicit DoPreprocessing(std::string* string): outputString(string) {}
+    // How much text to gather before handing it to an output sink.
+    static const size_t SinkChunkSize = 64 * 1024;
+
+    explicit DoPreprocessing(std::string* string, TShader::PreprocessedTextSink* sink = nullptr) :
+        outputString(string), outputSink(sink) {}
     bool operator()(TParseContextBase& parseContext, TPpContext& ppContext,
                     TInputScanner& input, bool versionWillBeError,
                     TSymbolTable&, TIntermediate&,
@@ -1200,14 +1302,26 @@ struct DoPreprocessing {
             if (token == PpAtomIdentifier)
                 lastTokenName = ppToken.name;
             lastToken = token;
-            if (token == PpAtomConstString)
+            if (token == PpAtomConstString) {
+                // The name has its escape sequences decoded, and is not written
+                // back with them.
+                parseContext.intermediate.setPreprocessedTextInexact();
                 outputBuffer += "\"";
+            }
             outputBuffer += ppToken.name;
             if (token == PpAtomConstString)
                 outputBuffer += "\"";
+
+            if (outputSink != nullptr && outputBuffer.size() >= SinkChunkSize) {
+                outputSink->write(outputBuffer.data(), outputBuffer.size());
+                outputBuffer.clear();
+            }
         } while (true);
         outputBuffer += '\n';
-        *outputString = std::move(outputBuffer);
+        if (outputSink != nullptr)
+            outputSink->write(outputBuffer.data(), outputBuffer.size());
+        else
+            *outputString = std::move(outputBuffer);
 
         bool success = true;
         if (parseContext.getNumErrors() > 0) {
@@ -1218,6 +1332,26 @@ struct DoPreprocessing {
         return success;
     }
     std::string* outputString;
+    TShader::PreprocessedTextSink* outputSink; // if not null, receives the output instead of outputString
+};
+
+// DoDependencyScan is a valid ProcessingContext template argument,
+// which only runs the preprocessor directives, to find the files included
+// and the macros tested.
+struct DoDependencyScan {
+    explicit DoDependencyScan(TShader::Dependencies& dependencies) : dependencies(dependencies) {}
+    bool operator()(TParseContextBase& parseContext, TPpContext& ppContext,
+                    TInputScanner& input, bool versionWillBeError,
+                    TSymbolTable&, TIntermediate&,
+                    EShOptimizationLevel, EShMessages)
+    {
+        parseContext.setScanner(&input);
+        ppContext.setInput(input, versionWillBeError);
+        ppContext.scanDependencies(dependencies);
+
+        return parseContext.getNumErrors() == 0;
+    }
+    TShader::Dependencies& dependencies;
 };
 
 // DoFullParse is a valid ProcessingConext template argument for fully
@@ -1275,14 +1409,46 @@ bool PreprocessDeferred(
     TShader::Includer& includer,
     TIntermediate& intermediate, // returned tree, etc.
     std::string* outputString,
-    TEnvironment* environment = nullptr)
+    TShader::PreprocessedTextSink* outputSink,
+    TEnvironment* environment = nullptr,
+    TPrecompiledPreamble* precompiledPreamble = nullptr)
 {
-    DoPreprocessing parser(outputString);
+    DoPreprocessing parser(outputString, outputSink);
     return ProcessDeferred(compiler, shaderStrings, numStrings, inputLengths, stringNames,
                            preamble, optLevel, resources, defaultVersion,
                            defaultProfile, forceDefaultVersionAndProfile, overrideVersion,
                            forwardCompatible, messages, intermediate, parser,
-                           false, includer, "", environment);
+                           false, includer, "", environment, false, precompiledPreamble);
+}
+
+// Like PreprocessDeferred, but only runs the preprocessor directives, adding
+// what they include and test to 'dependencies'.
+bool ScanDependenciesDeferred(
+    TCompiler* compiler,
+    const char* const shaderStrings[],
+    const int numStrings,
+    const int* inputLengths,
+    const char* const stringNames[],
+    const char* preamble,
+    const TBuiltInResource* resources,
+    int defaultVersion,
+    EProfile defaultProfile,
+    bool forceDefaultVersionAndProfile,
+    int overrideVersion,
+    bool forwardCompatible,
+    EShMessages messages,
+    TShader::Includer& includer,
+    TIntermediate& intermediate,
+    TShader::Dependencies& dependencies,
+    TEnvironment* environment,
+    TPrecompiledPreamble* precompiledPreamble)
+{
+    DoDependencyScan scanner(dependencies);
+    return ProcessDeferred(compiler, shaderStrings, numStrings, inputLengths, stringNames,
+                           preamble, EShOptNone, resources, defaultVersion,
+                           defaultProfile, forceDefaultVersionAndProfile, overrideVersion,
+                           forwardCompatible, messages, intermediate, scanner,
+                           false, includer, "", environment, false, precompiledPreamble);
 }
 
 //
@@ -1315,14 +1481,16 @@ bool CompileDeferred(
     TShader::Includer& includer,
     const std::string sourceEntryPointName = "",
     TEnvironment* environment = nullptr,
-    bool compileOnly = false)
+    bool compileOnly = false,
+    TPrecompiledPreamble* precompiledPreamble = nullptr)
 {
     DoFullParse parser;
     return ProcessDeferred(compiler, shaderStrings, numStrings, inputLengths, stringNames,
                            preamble, optLevel, resources, defaultVersion,
                            defaultProfile, forceDefaultVersionAndProfile, overrideVersion,
                            forwardCompatible, messages, intermediate, parser,
-                           true, includer, sourceEntryPointName, environment, compileOnly);
+                           true, includer, sourceEntryPointName, environment, compileOnly,
+                           precompiledPreamble);
 }
 
 } // end anonymous namespace for local functions
@@ -1397,6 +1565,11 @@ int ShFinalize()
     if (NumberOfClients > 0)
         return 1;
 
+#ifndef DISABLE_THREAD_SUPPORT
+    // Invalidate every thread's record of which tables exist.
+    SymbolTableGeneration.fetch_add(1, std::memory_order_release);
+#endif
+
     for (int version = 0; version < VersionCount; ++version) {
         for (int spvVersion = 0; spvVersion < SpvVersionCount; ++spvVersion) {
             for (int p = 0; p < ProfileCount; ++p) {
@@ -1736,10 +1909,21 @@ TIoMapper* GetGlslIoMapper() {
     return static_cast<TIoMapper*>(new TGlslIoMapper());
 }
 
+TPrecompiledPreamble::TPrecompiledPreamble(const char* text, size_t length, const char* name)
+    : text(text, length), name(name ? name : ""), macroSets(new TMacroSets)
+{
+}
+
+TPrecompiledPreamble::~TPrecompiledPreamble()
+{
+    delete macroSets;
+}
+
 TShader::TShader(EShLanguage s)
-    : stage(s), lengths(nullptr), stringNames(nullptr), preamble(""), overrideVersion(0)
+    : stage(s), lengths(nullptr), stringNames(nullptr), preamble(""), precompiledPreamble(nullptr),
+      overrideVersion(0)
 {
-    pool = new TPoolAllocator;
+    pool = new TPoolAllocator(GetThreadPoolAllocatorOptions());
     infoSink = new TInfoSink;
     compiler = new TDeferredCompiler(stage, *infoSink);
     intermediate = new TIntermediate(s);
@@ -1894,7 +2078,7 @@ bool TShader::parse(const TBuiltInResource* builtInResources, int defaultVersion
                            preamble, EShOptNone, builtInResources, defaultVersion,
                            defaultProfile, forceDefaultVersionAndProfile, overrideVersion,
                            forwardCompatible, messages, *intermediate, includer, sourceEntryPointName,
-                           &environment, compileOnly);
+                           &environment, compileOnly, precompiledPreamble);
 }
 
 // Fill in a string with the result of preprocessing ShaderStrings
@@ -1918,7 +2102,52 @@ bool TShader::preprocess(const TBuiltInResource* builtInResources,
                               EShOptNone, builtInResources, defaultVersion,
                               defaultProfile, forceDefaultVersionAndProfile, overrideVersion,
                               forwardCompatible, message, includer, *intermediate, output_string,
-                              &environment);
+                              nullptr, &environment, precompiledPreamble);
+}
+
+// Like the above, but passing the preprocessed text to outputSink a piece at a time.
+bool TShader::preprocess(const TBuiltInResource* builtInResources,
+                         int defaultVersion, EProfile defaultProfile,
+                         bool forceDefaultVersionAndProfile,
+                         bool forwardCompatible, EShMessages message,
+                         PreprocessedTextSink& outputSink,
+                         Includer& includer)
+{
+    SetThreadPoolAllocator(pool);
+
+    if (! preamble)
+        preamble = "";
+
+    return PreprocessDeferred(compiler, strings, numStrings, lengths, stringNames, preamble,
+                              EShOptNone, builtInResources, defaultVersion,
+                              defaultProfile, forceDefaultVersionAndProfile, overrideVersion,
+                              forwardCompatible, message, includer, *intermediate, nullptr,
+                              &outputSink, &environment, precompiledPreamble);
+}
+
+// Fill in 'dependencies' with what the shader includes and tests, running
+// nothing but its preprocessor directives.
+bool TShader::scanDependencies(const TBuiltInResource* builtInResources,
+                               int defaultVersion, EProfile defaultProfile,
+                               bool forceDefaultVersionAndProfile,
+                               bool forwardCompatible, EShMessages message,
+                               Includer& includer, Dependencies& dependencies)
+{
+    SetThreadPoolAllocator(pool);
+
+    if (! preamble)
+        preamble = "";
+
+    return ScanDependenciesDeferred(compiler, strings, numStrings, lengths, stringNames, preamble,
+                                    builtInResources, defaultVersion, defaultProfile,
+                                    forceDefaultVersionAndProfile, overrideVersion, forwardCompatible,
+                                    message, includer, *intermediate, dependencies, &environment,
+                                    precompiledPreamble);
+}
+
+bool TShader::isPreprocessedTextExact() const
+{
+    return ! intermediate->isPreprocessedTextInexact();
 }
 
 const char* TShader::getInfoLog()
@@ -1931,13 +2160,103 @@ const char* TShader::getInfoDebugLog()
     return infoSink->debug.c_str();
 }
 
-TProgram::TProgram() : reflection(nullptr), linked(false)
+//
+// Copies of array sizes, for incremental linking.
+//
+class TArraySizesCopies {
+public:
+    TArraySizesCopies() : saved(false) { }
+
+    bool isSaved() const { return saved; }
+
+    // Copy the given arrays, reusing the copies of an earlier save().
+    void save(const std::vector<TArraySizes*>& arrays)
+    {
+        for (size_t i = 0; i < arrays.size(); ++i) {
+            if (i == copies.size())
+                copies.push_back(new TArraySizes);
+            *copies[i] = *arrays[i];
+        }
+        saved = true;
+    }
+
+    // Return the given arrays, the ones last saved, to their saved states.
+    void restore(const std::vector<TArraySizes*>& arrays) const
+    {
+        for (size_t i = 0; i < arrays.size(); ++i)
+            *arrays[i] = *copies[i];
+    }
+
+    // Return true if the given arrays, the ones last saved, are as saved.
+    bool matches(const std::vector<TArraySizes*>& arrays) const
+    {
+        if (! saved)
+            return false;
+        for (size_t i = 0; i < arrays.size(); ++i) {
+            const TArraySizes& array = *arrays[i];
+            const TArraySizes& copy = *copies[i];
+            if (array.getNumDims() != copy.getNumDims() || array.isImplicitlySized() != copy.isImplicitlySized() ||
+                array.getImplicitSize() != copy.getImplicitSize() || array.isVariablyIndexed() != copy.isVariablyIndexed())
+                return false;
+            for (int d = 0; d < array.getNumDims(); ++d) {
+                if (array.getDimSize(d) != copy.getDimSize(d) || array.getDimNode(d) != copy.getDimNode(d))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::vector<TArraySizes*> copies;  // pool allocated
+    bool saved;
+};
+
+//
+// What linkStage() left in a stage, saved for incremental linking.
+//
+// crossStageCheck() and mapIO() change a stage only through the qualifiers of
+// its interface symbols, the initializers and array sizes of its linker
+// objects, and its error count, which is what is saved here.  Default uniform
+// blocks are the exception: merging them across stages rewrites block types
+// and trees.
+//
+// Given those, what crossStageCheck() adopts as the sizes of implicitly sized
+// arrays and how the default mapIO() maps the stage are determined, so they are
+// kept too, for a restored stage to reuse when it is linked as before.
+//
+struct TProgram::TStageState {
+    bool linked;        // what linkStage() returned
+    std::string log;    // what linkStage() wrote to the info log
+    int numErrors;
+    bool restorable;    // false if the stage has default uniform blocks
+    bool restored;      // true if the stage was not linked by the last link()
+
+    // The interface symbols and arrays, and how linkStage() left them
+    std::vector<std::pair<TIntermSymbol*, TQualifier>> qualifiers;
+    std::vector<std::pair<TIntermSymbol*, TConstUnionArray>> constArrays;
+    std::vector<TArraySizes*> arrays;
+    TArraySizesCopies linkedArrays;
+
+    // The arrays before and after crossStageCheck() adopted implicit sizes
+    TArraySizesCopies unadoptedArrays;
+    TArraySizesCopies adoptedArrays;
+
+    // The qualifiers and arrays the default mapIO() last mapped the stage
+    // from, and the qualifiers it mapped them to, in the order of qualifiers
+    bool mapped;
+    std::vector<TQualifier> unmappedQualifiers;
+    TArraySizesCopies unmappedArrays;
+    std::vector<TQualifier> mappedQualifiers;
+};
+
+TProgram::TProgram() : reflection(nullptr), linked(false), incrementalLink(false), captureResourceLayout(false)
 {
-    pool = new TPoolAllocator;
+    pool = new TPoolAllocator(GetThreadPoolAllocatorOptions());
     infoSink = new TInfoSink;
     for (int s = 0; s < EShLangCount; ++s) {
         intermediate[s] = nullptr;
         newedIntermediate[s] = false;
+        stageState[s] = nullptr;
     }
 }
 
@@ -1946,23 +2265,57 @@ TProgram::~TProgram()
     delete infoSink;
     delete reflection;
 
-    for (int s = 0; s < EShLangCount; ++s)
+    for (int s = 0; s < EShLangCount; ++s) {
         if (newedIntermediate[s])
             delete intermediate[s];
+        delete stageState[s];
+    }
 
     delete pool;
 }
 
+bool TProgram::replaceShader(TShader* oldShader, TShader* newShader)
+{
+    const EShLanguage stage = oldShader->stage;
+    if (newShader->stage != stage || stages[stage].size() != 1 || stages[stage].front() != oldShader)
+        return false;
+    if (linked && ! incrementalLink)
+        return false;
+
+    stages[stage].front() = newShader;
+
+    // The stage needs linkStage() again, and reflection refers to the old shader.
+    delete stageState[stage];
+    stageState[stage] = nullptr;
+    intermediate[stage] = nullptr;
+    delete reflection;
+    reflection = nullptr;
+
+    return true;
+}
+
 //
 // Merge the compilation units within each stage into a single TIntermediate.
 // All starting compilation units need to be the result of calling TShader::parse().
 //
+// A linked program can only be linked again, incrementally, after
+// replaceShader().
+//
 // Return true for success.
 //
 bool TProgram::link(EShMessages messages)
 {
-    if (linked)
-        return false;
+    if (linked) {
+        bool replaced = false;
+        for (int s = 0; s < EShLangCount; ++s) {
+            if (! stages[s].empty() && stageState[s] == nullptr)
+                replaced = true;
+        }
+        if (! replaced)
+            return false;
+        infoSink->info.erase();
+        infoSink->debug.erase();
+    }
     linked = true;
 
     bool error = false;
@@ -1970,7 +2323,17 @@ bool TProgram::link(EShMessages messages)
     SetThreadPoolAllocator(pool);
 
     for (int s = 0; s < EShLangCount; ++s) {
-        if (! linkStage((EShLanguage)s, messages))
+        if (stageState[s] != nullptr) {
+            // Unchanged since the last link: undo what the other stages did to it.
+            if (! restoreStageState((EShLanguage)s))
+                error = true;
+        } else if (incrementalLink) {
+            const std::string logBefore = infoSink->info.c_str();
+            const bool stageLinked = linkStage((EShLanguage)s, messages);
+            saveStageState((EShLanguage)s, stageLinked, infoSink->info.c_str() + logBefore.size());
+            if (! stageLinked)
+                error = true;
+        } else if (! linkStage((EShLanguage)s, messages))
             error = true;
     }
 
@@ -2055,6 +2418,96 @@ bool TProgram::linkStage(EShLanguage stage, EShMessages messages)
     return intermediate[stage]->getNumErrors() == 0;
 }
 
+//
+// Save what crossStageCheck() and mapIO() may change in a stage just linked by
+// linkStage(), see TStageState.
+//
+void TProgram::saveStageState(EShLanguage stage, bool stageLinked, const std::string& log)
+{
+    if (intermediate[stage] == nullptr)
+        return;
+
+    TStageState* state = new TStageState;
+    stageState[stage] = state;
+    state->linked = stageLinked;
+    state->log = log;
+    state->numErrors = intermediate[stage]->getNumErrors();
+    state->restorable = true;
+    state->restored = false;
+    state->mapped = false;
+
+    TIntermNode* root = intermediate[stage]->getTreeRoot();
+    if (root == nullptr)
+        return;
+
+    const auto isInterface = [](const TQualifier& qualifier) {
+        return qualifier.storage == EvqVaryingIn || qualifier.storage == EvqVaryingOut ||
+               qualifier.isUniformOrBuffer();
+    };
+
+    for (TIntermNode* node : intermediate[stage]->findLinkerObjects()->getSequence()) {
+        TIntermSymbol* symbol = node->getAsSymbolNode();
+        if (symbol->getQualifier().defaultBlock) {
+            state->restorable = false;
+            return;
+        }
+        if (! isInterface(symbol->getQualifier()))
+            continue;
+        state->constArrays.push_back(std::make_pair(symbol, symbol->getConstArray()));
+        symbol->getType().contains([state](const TType* type) {
+            if (type->isArray())
+                state->arrays.push_back(const_cast<TType*>(type)->getArraySizes());
+            return false;
+        });
+    }
+    state->linkedArrays.save(state->arrays);
+
+    class TInterfaceTraverser : public TIntermTraverser {
+    public:
+        TInterfaceTraverser(TStageState& state, bool (*isInterface)(const TQualifier&))
+            : state(state), isInterface(isInterface) { }
+
+        virtual void visitSymbol(TIntermSymbol* symbol)
+        {
+            if (isInterface(symbol->getQualifier()))
+                state.qualifiers.push_back(std::make_pair(symbol, symbol->getQualifier()));
+        }
+
+    private:
+        TStageState& state;
+        bool (*isInterface)(const TQualifier&);
+    } interfaceTraverser(*state, isInterface);
+    root->traverse(&interfaceTraverser);
+}
+
+//
+// Return a stage to how linkStage() left it, and append what linkStage()
+// logged for it.
+//
+// Return false if linkStage() failed, or the stage cannot be restored.
+//
+bool TProgram::restoreStageState(EShLanguage stage)
+{
+    TStageState& state = *stageState[stage];
+    state.restored = true;
+    if (! state.restorable) {
+        infoSink->info.prefix(EPrefixError);
+        infoSink->info << "Cannot link the " << StageName(stage) << " stage again: its default uniform blocks "
+                          "were merged with other stages; replace its shader too\n";
+        return false;
+    }
+
+    for (const auto& saved : state.qualifiers)
+        saved.first->getWritableType().getQualifier() = saved.second;
+    for (const auto& saved : state.constArrays)
+        saved.first->setConstArray(saved.second);
+    state.linkedArrays.restore(state.arrays);
+    intermediate[stage]->setNumErrors(state.numErrors);
+    infoSink->info << state.log.c_str();
+
+    return state.linked;
+}
+
 //
 // Check that there are no errors in linker objects accross stages
 //
@@ -2089,10 +2542,26 @@ bool TProgram::crossStageCheck(EShMessages messages) {
         }
     } finalLinkTraverser;
 
+    // For incremental linking, a restored stage whose interface arrays are as
+    // they were before its last traversal only needs their sizes from after it.
+    const auto finalLink = [this, &finalLinkTraverser](TIntermediate* stageIntermediate) {
+        TStageState* state = stageState[stageIntermediate->getStage()];
+        if (state != nullptr && state->restored && state->adoptedArrays.isSaved() &&
+            state->unadoptedArrays.matches(state->arrays)) {
+            state->adoptedArrays.restore(state->arrays);
+            return;
+        }
+        if (state != nullptr)
+            state->unadoptedArrays.save(state->arrays);
+        stageIntermediate->getTreeRoot()->traverse(&finalLinkTraverser);
+        if (state != nullptr)
+            state->adoptedArrays.save(state->arrays);
+    };
+
     // no extra linking if there is only one stage
     if (! (activeStages.size() > 1)) {
         if (activeStages.size() == 1 && activeStages[0]->getTreeRoot()) {
-            activeStages[0]->getTreeRoot()->traverse(&finalLinkTraverser);
+            finalLink(activeStages[0]);
         }
         return true;
     }
@@ -2120,7 +2589,7 @@ bool TProgram::crossStageCheck(EShMessages messages) {
     // update implicit array sizes across shader stages
     for (unsigned int i = 0; i < activeStages.size(); ++i) {
         activeStages[i]->mergeImplicitArraySizes(*infoSink, uniforms);
-        activeStages[i]->getTreeRoot()->traverse(&finalLinkTraverser);
+        finalLink(activeStages[i]);
     }
 
     // copy final definition of global block back into each stage
@@ -2243,14 +2712,66 @@ bool TProgram::mapIO(TIoMapResolver* pResolver, TIoMapper* pIoMapper)
         ioMapper = &defaultIOMapper;
     else
         ioMapper = pIoMapper;
+    const bool reuseMappings = pResolver == nullptr && pIoMapper == nullptr;
     for (int s = 0; s < EShLangCount; ++s) {
         if (intermediate[s]) {
+            TStageState* state = reuseMappings ? stageState[s] : nullptr;
+            if (state != nullptr && ! state->restorable)
+                state = nullptr;
+            if (state != nullptr && mapStageAsBefore(*state))
+                continue;
+
+            if (state != nullptr) {
+                state->mapped = false;
+                state->unmappedQualifiers.clear();
+                for (const auto& saved : state->qualifiers)
+                    state->unmappedQualifiers.push_back(saved.first->getQualifier());
+                state->unmappedArrays.save(state->arrays);
+            }
             if (! ioMapper->addStage((EShLanguage)s, *intermediate[s], *infoSink, pResolver))
                 return false;
+            if (state != nullptr) {
+                state->mapped = true;
+                state->mappedQualifiers.clear();
+                for (const auto& saved : state->qualifiers)
+                    state->mappedQualifiers.push_back(saved.first->getQualifier());
+            }
         }
     }
 
-    return ioMapper->doMap(pResolver, *infoSink);
+    if (! ioMapper->doMap(pResolver, *infoSink))
+        return false;
+
+    if (captureResourceLayout)
+        BuildResourceLayout(intermediate, resourceLayout);
+
+    return true;
+}
+
+//
+// If the default mapIO() would map a stage as it did last time, because the
+// checks across stages left the same qualifiers as then, reapply that mapping.
+//
+// Return true if the mapping was reapplied.
+//
+bool TProgram::mapStageAsBefore(const TStageState& state)
+{
+    if (! state.mapped || ! state.unmappedArrays.matches(state.arrays))
+        return false;
+
+    // The qualifiers crossStageCheck() changes, see TStageState.
+    for (size_t i = 0; i < state.qualifiers.size(); ++i) {
+        const TQualifier& qualifier = state.qualifiers[i].first->getQualifier();
+        const TQualifier& unmapped = state.unmappedQualifiers[i];
+        if (qualifier.storage != unmapped.storage || qualifier.layoutBinding != unmapped.layoutBinding ||
+            qualifier.layoutLocation != unmapped.layoutLocation)
+            return false;
+    }
+
+    for (size_t i = 0; i < state.qualifiers.size(); ++i)
+        state.qualifiers[i].first->getWritableType().getQualifier() = state.mappedQualifiers[i];
+
+    return true;
 }
 
 } // end namespace glslang
@@ -44,6 +44,8 @@
 
 #include "SymbolTable.h"
 
+#include <cstring>
+
 namespace glslang {
 
 //
@@ -269,9 +271,10 @@ void TAnonMember::dump(TInfoSink& TInfoSink, bool) const
 
 void TSymbolTableLevel::dump(TInfoSink& infoSink, bool complete) const
 {
-    tLevel::const_iterator it;
-    for (it = level.begin(); it != level.end(); ++it)
-        (*it).second->dump(infoSink, complete);
+    TVector<const tEntry*> sorted;
+    getSortedEntries(sorted);
+    for (const tEntry* entry : sorted)
+        entry->symbol->dump(infoSink, complete);
 }
 
 void TSymbolTable::dump(TInfoSink& infoSink, bool complete) const
@@ -296,61 +299,145 @@ TFunction::~TFunction()
 //
 TSymbolTableLevel::~TSymbolTableLevel()
 {
-    for (tLevel::iterator it = level.begin(); it != level.end(); ++it) {
-        const TString& name = it->first;
+    for (tEntry* entry : slots) {
+        if (entry == nullptr)
+            continue;
+        const TString& name = entry->key;
         auto retargetIter = std::find_if(retargetedSymbols.begin(), retargetedSymbols.end(),
                                       [&name](const std::pair<TString, TString>& i) { return i.first == name; });
         if (retargetIter == retargetedSymbols.end())
-            delete (*it).second;
+            delete entry->symbol;
     }
 
 
     delete [] defaultPrecision;
 }
 
+namespace {
+
+// Put an entry into an open-addressed table that has room for it.
+template<class T> void PlaceInSlots(TVector<T*>& slots, T* item)
+{
+    const size_t mask = slots.size() - 1;
+    size_t s = item->hash & mask;
+    while (slots[s] != nullptr)
+        s = (s + 1) & mask;
+    slots[s] = item;
+}
+
+// Make room for 'count' items, keeping the table at most half full.
+template<class T> void ReserveSlots(TVector<T*>& slots, unsigned int count)
+{
+    if (2 * (size_t)count <= slots.size())
+        return;
+
+    TVector<T*> old(slots.get_allocator());
+    old.swap(slots);
+    slots.assign(old.empty() ? 8 : 2 * old.size(), nullptr);
+    for (T* item : old) {
+        if (item != nullptr)
+            PlaceInSlots(slots, item);
+    }
+}
+
+} // end anonymous namespace
+
+//
+// Add a named mapping, unless 'key' is already mapped at this level.
+// Mangled function names are also filed under their base name, so all
+// overloads of a name can be found without scanning the level.
+//
+bool TSymbolTableLevel::insertEntry(const TString& key, TSymbol* symbol)
+{
+    const size_t baseLength = baseNameLength(key);
+    const unsigned int baseHash = hashName(key.c_str(), baseLength);
+    const unsigned int hash = hashName(key.c_str() + baseLength, key.size() - baseLength, baseHash);
+    if (findEntry(key.c_str(), key.size(), hash) != nullptr)
+        return false;
+
+    // allocate from the pool the level was created in, like the slots
+    TPoolAllocator& pool = slots.get_allocator().getAllocator();
+    tEntry* entry = new (pool.allocate(sizeof(tEntry))) tEntry{ key, hash, symbol };
+    ReserveSlots(slots, ++numEntries);
+    PlaceInSlots(slots, entry);
+
+    if (baseLength == key.size())
+        return true;
+
+    tOverloadSet* overloads = const_cast<tOverloadSet*>(findOverloadSet(key.c_str(), baseLength, baseHash));
+    if (overloads == nullptr) {
+        overloads = new (pool.allocate(sizeof(tOverloadSet)))
+            tOverloadSet{ entry, baseLength, baseHash, TVector<tEntry*>(slots.get_allocator()) };
+        ReserveSlots(overloadSlots, ++numOverloadSets);
+        PlaceInSlots(overloadSlots, overloads);
+    }
+    auto at = std::lower_bound(overloads->entries.begin(), overloads->entries.end(), entry,
+                               [](const tEntry* a, const tEntry* b) { return a->key < b->key; });
+    overloads->entries.insert(at, entry);
+
+    return true;
+}
+
+//
+// The overloads of the function 'name', unless a variable of that name,
+// which hides them, is at this level.
+//
+const TSymbolTableLevel::tOverloadSet* TSymbolTableLevel::findFunctionsNamed(const char* name) const
+{
+    const size_t length = strlen(name);
+    const unsigned int hash = hashName(name, length);
+    if (findEntry(name, length, hash) != nullptr)
+        return nullptr;
+
+    return findOverloadSet(name, length, hash);
+}
+
+//
+// The level's entries in the order of their keys, for walks whose results
+// (dumps, anonymous ids of clones) depend on the order.
+//
+void TSymbolTableLevel::getSortedEntries(TVector<const tEntry*>& sorted) const
+{
+    sorted.reserve(numEntries);
+    for (const tEntry* entry : slots) {
+        if (entry != nullptr)
+            sorted.push_back(entry);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const tEntry* a, const tEntry* b) { return a->key < b->key; });
+}
+
 //
 // Change all function entries in the table with the non-mangled name
 // to be related to the provided built-in operation.
 //
 void TSymbolTableLevel::relateToOperator(const char* name, TOperator op)
 {
-    tLevel::const_iterator candidate = level.lower_bound(name);
-    while (candidate != level.end()) {
-        const TString& candidateName = (*candidate).first;
-        TString::size_type parenAt = candidateName.find_first_of('(');
-        if (parenAt != candidateName.npos && candidateName.compare(0, parenAt, name) == 0) {
-            TFunction* function = (*candidate).second->getAsFunction();
-            function->relateToOperator(op);
-        } else
-            break;
-        ++candidate;
-    }
+    const tOverloadSet* overloads = findFunctionsNamed(name);
+    if (overloads == nullptr)
+        return;
+    for (const tEntry* entry : overloads->entries)
+        entry->symbol->getAsFunction()->relateToOperator(op);
 }
 
 // Make all function overloads of the given name require an extension(s).
 // Should only be used for a version/profile that actually needs the extension(s).
 void TSymbolTableLevel::setFunctionExtensions(const char* name, int num, const char* const extensions[])
 {
-    tLevel::const_iterator candidate = level.lower_bound(name);
-    while (candidate != level.end()) {
-        const TString& candidateName = (*candidate).first;
-        TString::size_type parenAt = candidateName.find_first_of('(');
-        if (parenAt != candidateName.npos && candidateName.compare(0, parenAt, name) == 0) {
-            TSymbol* symbol = candidate->second;
-            symbol->setExtensions(num, extensions);
-        } else
-            break;
-        ++candidate;
-    }
+    const tOverloadSet* overloads = findFunctionsNamed(name);
+    if (overloads == nullptr)
+        return;
+    for (const tEntry* entry : overloads->entries)
+        entry->symbol->setExtensions(num, extensions);
 }
 
 // Make a single function require an extension(s). i.e., this will only set the extensions for the symbol that matches 'name' exactly.
-// This is different from setFunctionExtensions, which uses std::map::lower_bound to effectively set all symbols that start with 'name'.
+// This is different from setFunctionExtensions, which sets all the overloads whose mangled name starts with 'name'.
 // Should only be used for a version/profile that actually needs the extension(s).
 void TSymbolTableLevel::setSingleFunctionExtensions(const char* name, int num, const char* const extensions[])
 {
-    if (auto candidate = level.find(name); candidate != level.end()) {
-        candidate->second->setExtensions(num, extensions);
+    size_t length = strlen(name);
+    if (const tEntry* entry = findEntry(name, length, hashName(name, length)); entry != nullptr) {
+        entry->symbol->setExtensions(num, extensions);
     }
 }
 
@@ -359,8 +446,10 @@ void TSymbolTableLevel::setSingleFunctionExtensions(const char* name, int num, c
 //
 void TSymbolTableLevel::readOnly()
 {
-    for (tLevel::iterator it = level.begin(); it != level.end(); ++it)
-        (*it).second->makeReadOnly();
+    for (tEntry* entry : slots) {
+        if (entry != nullptr)
+            entry->symbol->makeReadOnly();
+    }
 }
 
 //
@@ -455,9 +544,10 @@ TSymbolTableLevel* TSymbolTableLevel::clone() const
         symTableLevel->retargetedSymbols.push_back({s.first, s.second});
     }
     std::vector<bool> containerCopied(anonId, false);
-    tLevel::const_iterator iter;
-    for (iter = level.begin(); iter != level.end(); ++iter) {
-        const TAnonMember* anon = iter->second->getAsAnonMember();
+    TVector<const tEntry*> sorted;
+    getSortedEntries(sorted);
+    for (const tEntry* entry : sorted) {
+        const TAnonMember* anon = entry->symbol->getAsAnonMember();
         if (anon) {
             // Insert all the anonymous members of this same container at once,
             // avoid inserting the remaining members in the future, once this has been done,
@@ -470,12 +560,12 @@ TSymbolTableLevel* TSymbolTableLevel::clone() const
                 containerCopied[anon->getAnonId()] = true;
             }
         } else {
-            const TString& name = iter->first;
+            const TString& name = entry->key;
             auto retargetIter = std::find_if(retargetedSymbols.begin(), retargetedSymbols.end(),
                                           [&name](const std::pair<TString, TString>& i) { return i.first == name; });
             if (retargetIter != retargetedSymbols.end())
                 continue;
-            symTableLevel->insert(*iter->second->clone(), false);
+            symTableLevel->insert(*entry->symbol->clone(), false);
         }
     }
     // Now point retargeted symbols to the newly created versions of them
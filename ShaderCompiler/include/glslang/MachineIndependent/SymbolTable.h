@@ -409,11 +409,35 @@ protected:
 class TSymbolTableLevel {
 public:
     POOL_ALLOCATOR_NEW_DELETE(GetThreadPoolAllocator())
-    TSymbolTableLevel() : defaultPrecision(nullptr), anonId(0), thisLevel(false) { }
+    TSymbolTableLevel() : numEntries(0), numOverloadSets(0), defaultPrecision(nullptr), anonId(0), thisLevel(false) { }
     ~TSymbolTableLevel();
 
+    //
+    // Names are found through the FNV-1a hash of their characters (the same hash
+    // Common.h uses for TString).  Callers probing several levels compute it once
+    // and pass it down.  The hash can be resumed, so the hash of a mangled name
+    // continues from the hash of its base name.
+    //
+    static unsigned int hashName(const char* name, size_t length, unsigned int hash = 2166136261U)
+    {
+        for (size_t c = 0; c < length; ++c) {
+            hash ^= (unsigned int)name[c];
+            hash *= 16777619U;
+        }
+
+        return hash;
+    }
+    static unsigned int hashName(const TString& name) { return hashName(name.c_str(), name.size()); }
+
+    // Length of the part of a mangled function name before its '(', or of the whole name.
+    static size_t baseNameLength(const TString& name)
+    {
+        size_t parenAt = name.find_first_of('(');
+        return parenAt == name.npos ? name.size() : parenAt;
+    }
+
     bool insert(const TString& name, TSymbol* symbol) {
-        return level.insert(tLevelPair(name, symbol)).second;
+        return insertEntry(name, symbol);
     }
 
     bool insert(TSymbol& symbol, bool separateNameSpaces, const TString& forcedKeyName = TString())
@@ -423,7 +447,7 @@ public:
         //
         const TString& name = symbol.getName();
         if (forcedKeyName.length()) {
-            return level.insert(tLevelPair(forcedKeyName, &symbol)).second;
+            return insertEntry(forcedKeyName, &symbol);
         }
         else if (name == "") {
             symbol.getAsVariable()->setAnonId(anonId++);
@@ -436,20 +460,20 @@ public:
             return insertAnonymousMembers(symbol, 0);
         } else {
             // Check for redefinition errors:
-            // - STL itself will tell us if there is a direct name collision, with name mangling, at this level
+            // - the table itself will tell us if there is a direct name collision, with name mangling, at this level
             // - additionally, check for function-redefining-variable name collisions
             const TString& insertName = symbol.getMangledName();
             if (symbol.getAsFunction()) {
                 // make sure there isn't a variable of this name
-                if (! separateNameSpaces && level.find(name) != level.end())
+                if (! separateNameSpaces && findEntry(name) != nullptr)
                     return false;
 
                 // insert, and whatever happens is okay
-                level.insert(tLevelPair(insertName, &symbol));
+                insertEntry(insertName, &symbol);
 
                 return true;
             } else
-                return level.insert(tLevelPair(insertName, &symbol)).second;
+                return insertEntry(insertName, &symbol);
         }
     }
 
@@ -470,7 +494,7 @@ public:
         const TTypeList& types = *symbol.getAsVariable()->getType().getStruct();
         for (unsigned int m = firstMember; m < types.size(); ++m) {
             TAnonMember* member = new TAnonMember(&types[m].type->getFieldName(), m, *symbol.getAsVariable(), symbol.getAsVariable()->getAnonId());
-            if (! level.insert(tLevelPair(member->getMangledName(), member)).second)
+            if (! insertEntry(member->getMangledName(), member))
                 return false;
         }
 
@@ -478,74 +502,75 @@ public:
     }
 
     void retargetSymbol(const TString& from, const TString& to) {
-        tLevel::const_iterator fromIt = level.find(from);
-        tLevel::const_iterator toIt = level.find(to);
-        if (fromIt == level.end() || toIt == level.end())
+        tEntry* fromEntry = findEntry(from);
+        const tEntry* toEntry = findEntry(to);
+        if (fromEntry == nullptr || toEntry == nullptr)
             return;
-        delete fromIt->second;
-        level[from] = toIt->second;
+        delete fromEntry->symbol;
+        fromEntry->symbol = toEntry->symbol;
         retargetedSymbols.push_back({from, to});
     }
 
     TSymbol* find(const TString& name) const
     {
-        tLevel::const_iterator it = level.find(name);
-        if (it == level.end())
+        return find(name, hashName(name));
+    }
+
+    // Same, with the hash of 'name' already computed by the caller.
+    TSymbol* find(const TString& name, unsigned int hash) const
+    {
+        const tEntry* entry = findEntry(name.c_str(), name.size(), hash);
+        if (entry == nullptr)
             return nullptr;
         else
-            return (*it).second;
+            return entry->symbol;
     }
 
-    void findFunctionNameList(const TString& name, TVector<const TFunction*>& list)
+    void findFunctionNameList(const TString& name, TVector<const TFunction*>& list) const
     {
-        size_t parenAt = name.find_first_of('(');
-        TString base(name, 0, parenAt + 1);
+        size_t baseLength = baseNameLength(name);
+        findFunctionNameList(name.c_str(), baseLength, hashName(name.c_str(), baseLength), list);
+    }
 
-        tLevel::const_iterator begin = level.lower_bound(base);
-        base[parenAt] = ')';  // assume ')' is lexically after '('
-        tLevel::const_iterator end = level.upper_bound(base);
-        for (tLevel::const_iterator it = begin; it != end; ++it)
-            list.push_back(it->second->getAsFunction());
+    // Same, for a base name (the part of a mangled name before the '(') and its hash.
+    void findFunctionNameList(const char* base, size_t length, unsigned int hash, TVector<const TFunction*>& list) const
+    {
+        const tOverloadSet* overloads = findOverloadSet(base, length, hash);
+        if (overloads == nullptr)
+            return;
+        for (const tEntry* entry : overloads->entries)
+            list.push_back(entry->symbol->getAsFunction());
     }
 
     // See if there is already a function in the table having the given non-function-style name.
     bool hasFunctionName(const TString& name) const
     {
-        tLevel::const_iterator candidate = level.lower_bound(name);
-        if (candidate != level.end()) {
-            const TString& candidateName = (*candidate).first;
-            TString::size_type parenAt = candidateName.find_first_of('(');
-            if (parenAt != candidateName.npos && candidateName.compare(0, parenAt, name) == 0)
-
-                return true;
-        }
+        // a variable of exactly this name takes precedence over functions sharing it
+        unsigned int hash = hashName(name);
+        if (findEntry(name.c_str(), name.size(), hash) != nullptr)
+            return false;
 
-        return false;
+        return findOverloadSet(name.c_str(), name.size(), hash) != nullptr;
     }
 
     // See if there is a variable at this level having the given non-function-style name.
     // Return true if name is found, and set variable to true if the name was a variable.
     bool findFunctionVariableName(const TString& name, bool& variable) const
     {
-        tLevel::const_iterator candidate = level.lower_bound(name);
-        if (candidate != level.end()) {
-            const TString& candidateName = (*candidate).first;
-            TString::size_type parenAt = candidateName.find_first_of('(');
-            if (parenAt == candidateName.npos) {
-                // not a mangled name
-                if (candidateName == name) {
-                    // found a variable name match
-                    variable = true;
-                    return true;
-                }
-            } else {
-                // a mangled name
-                if (candidateName.compare(0, parenAt, name) == 0) {
-                    // found a function name match
-                    variable = false;
-                    return true;
-                }
-            }
+        return findFunctionVariableName(name, hashName(name), variable);
+    }
+
+    bool findFunctionVariableName(const TString& name, unsigned int hash, bool& variable) const
+    {
+        if (findEntry(name.c_str(), name.size(), hash) != nullptr) {
+            // found a variable name match
+            variable = true;
+            return true;
+        }
+        if (findOverloadSet(name.c_str(), name.size(), hash) != nullptr) {
+            // found a function name match
+            variable = false;
+            return true;
         }
 
         return false;
@@ -592,11 +617,66 @@ protected:
     explicit TSymbolTableLevel(TSymbolTableLevel&);
     TSymbolTableLevel& operator=(TSymbolTableLevel&);
 
-    typedef std::map<TString, TSymbol*, std::less<TString>, pool_allocator<std::pair<const TString, TSymbol*> > > tLevel;
-    typedef const tLevel::value_type tLevelPair;
-    typedef std::pair<tLevel::iterator, bool> tInsertResult;
+    // A named mapping, keyed by the (mangled) name.
+    struct tEntry {
+        TString key;
+        unsigned int hash;
+        TSymbol* symbol;
+    };
+
+    // The entries for all overloads of one function name, sorted by mangled name.
+    struct tOverloadSet {
+        const tEntry* first;    // the first one inserted, whose key starts with the base name
+        size_t baseLength;
+        unsigned int hash;      // of the base name
+        TVector<tEntry*> entries;
+    };
+
+    const tEntry* findEntry(const char* name, size_t length, unsigned int hash) const
+    {
+        if (slots.empty())
+            return nullptr;
+
+        const size_t mask = slots.size() - 1;
+        for (size_t s = hash & mask; slots[s] != nullptr; s = (s + 1) & mask) {
+            const tEntry* entry = slots[s];
+            if (entry->hash == hash && entry->key.size() == length && entry->key.compare(0, length, name, length) == 0)
+                return entry;
+        }
+
+        return nullptr;
+    }
+    tEntry* findEntry(const TString& name)
+    {
+        return const_cast<tEntry*>(findEntry(name.c_str(), name.size(), hashName(name)));
+    }
+
+    const tOverloadSet* findOverloadSet(const char* base, size_t length, unsigned int hash) const
+    {
+        if (overloadSlots.empty())
+            return nullptr;
 
-    tLevel level;  // named mappings
+        const size_t mask = overloadSlots.size() - 1;
+        for (size_t s = hash & mask; overloadSlots[s] != nullptr; s = (s + 1) & mask) {
+            const tOverloadSet* overloads = overloadSlots[s];
+            if (overloads->hash == hash && overloads->baseLength == length &&
+                overloads->first->key.compare(0, length, base, length) == 0)
+                return overloads;
+        }
+
+        return nullptr;
+    }
+
+    bool insertEntry(const TString& key, TSymbol* symbol);
+    const tOverloadSet* findFunctionsNamed(const char* name) const;
+    void getSortedEntries(TVector<const tEntry*>& sorted) const;
+
+    // Open addressing with linear probing; both tables have a power-of-two size
+    // and are kept at most half full.
+    TVector<tEntry*> slots;                 // named mappings
+    TVector<tOverloadSet*> overloadSlots;   // mangled function names, by base name
+    unsigned int numEntries;
+    unsigned int numOverloadSets;
     TPrecisionQualifier *defaultPrecision;
     // pair<FromName, ToName>
     TVector<std::pair<TString, TString>> retargetedSymbols;
@@ -782,13 +862,14 @@ public:
     // at a built-in level or the current top-scope level.
     TSymbol* find(const TString& name, bool* builtIn = nullptr, bool* currentScope = nullptr, int* thisDepthP = nullptr)
     {
+        const unsigned int hash = TSymbolTableLevel::hashName(name);
         int level = currentLevel();
         TSymbol* symbol;
         int thisDepth = 0;
         do {
             if (table[level]->isThisLevel())
                 ++thisDepth;
-            symbol = table[level]->find(name);
+            symbol = table[level]->find(name, hash);
             --level;
         } while (symbol == nullptr && level >= 0);
         level++;
@@ -816,13 +897,14 @@ public:
     // found in.
     TSymbol* find(const TString& name, int& thisDepth)
     {
+        const unsigned int hash = TSymbolTableLevel::hashName(name);
         int level = currentLevel();
         TSymbol* symbol;
         thisDepth = 0;
         do {
             if (table[level]->isThisLevel())
                 ++thisDepth;
-            symbol = table[level]->find(name);
+            symbol = table[level]->find(name, hash);
             --level;
         } while (symbol == nullptr && level >= 0);
 
@@ -837,10 +919,11 @@ public:
         if (separateNameSpaces)
             return false;
 
+        const unsigned int hash = TSymbolTableLevel::hashName(name);
         int level = currentLevel();
         do {
             bool variable;
-            bool found = table[level]->findFunctionVariableName(name, variable);
+            bool found = table[level]->findFunctionVariableName(name, hash, variable);
             if (found)
                 return variable;
             --level;
@@ -851,11 +934,15 @@ public:
 
     void findFunctionNameList(const TString& name, TVector<const TFunction*>& list, bool& builtIn)
     {
+        // Every level looks the overloads up by the base name, so split it off once
+        const size_t baseLength = TSymbolTableLevel::baseNameLength(name);
+        const unsigned int hash = TSymbolTableLevel::hashName(name.c_str(), baseLength);
+
         // For user levels, return the set found in the first scope with a match
         builtIn = false;
         int level = currentLevel();
         do {
-            table[level]->findFunctionNameList(name, list);
+            table[level]->findFunctionNameList(name.c_str(), baseLength, hash, list);
             --level;
         } while (list.empty() && level >= globalLevel);
 
@@ -865,7 +952,7 @@ public:
         // Gather across all built-in levels; they don't hide each other
         builtIn = true;
         do {
-            table[level]->findFunctionNameList(name, list);
+            table[level]->findFunctionNameList(name.c_str(), baseLength, hash, list);
             --level;
         } while (level >= 0);
     }
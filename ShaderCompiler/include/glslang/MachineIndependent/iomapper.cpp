@@ -163,18 +163,28 @@ struct TVarLivePair : std::pair<const TString, TVarEntryInfo> {
 typedef std::vector<TVarLivePair> TVarLiveVector;
 
 
+// Also collects, if given a vector for them, the in/out and uniform symbol
+// nodes visited, which are those a TVarSetTraverser traversing all code
+// would set.
 class TVarGatherTraverser : public TLiveTraverser {
 public:
-    TVarGatherTraverser(const TIntermediate& i, bool traverseDeadCode, TVarLiveMap& inList, TVarLiveMap& outList, TVarLiveMap& uniformList)
+    TVarGatherTraverser(const TIntermediate& i, bool traverseDeadCode, TVarLiveMap& inList, TVarLiveMap& outList, TVarLiveMap& uniformList,
+                        std::vector<TIntermSymbol*>* interfaceSymbols = nullptr)
       : TLiveTraverser(i, traverseDeadCode, true, true, false)
       , inputList(inList)
       , outputList(outList)
       , uniformList(uniformList)
+      , interfaceSymbols(interfaceSymbols)
     {
     }
 
     virtual void visitSymbol(TIntermSymbol* base)
     {
+        if (interfaceSymbols != nullptr &&
+            (base->getQualifier().storage == EvqVaryingIn || base->getQualifier().storage == EvqVaryingOut ||
+             base->getQualifier().isUniformOrBuffer()))
+            interfaceSymbols->push_back(base);
+
         TVarLiveMap* target = nullptr;
         if (base->getQualifier().storage == EvqVaryingIn)
             target = &inputList;
@@ -203,6 +213,7 @@ private:
     TVarLiveMap&    inputList;
     TVarLiveMap&    outputList;
     TVarLiveMap&    uniformList;
+    std::vector<TIntermSymbol*>* interfaceSymbols;
 };
 
 class TVarSetTraverser : public TLiveTraverser
@@ -888,38 +899,68 @@ bool TDefaultIoResolverBase::doAutoBindingMapping() const { return referenceInte
 
 bool TDefaultIoResolverBase::doAutoLocationMapping() const { return referenceIntermediate.getAutoMapLocations(); }
 
-TDefaultIoResolverBase::TSlotSet::iterator TDefaultIoResolverBase::findSlot(int set, int slot) {
-    return std::lower_bound(slots[set].begin(), slots[set].end(), slot);
+bool TDefaultIoResolverBase::TSlotSet::isUsed(int slot) const {
+    auto word = words.find(slot >> 6);
+    return word != words.end() && (word->second >> (slot & 63) & 1) != 0;
+}
+
+void TDefaultIoResolverBase::TSlotSet::reserve(int slot, int size) {
+    for (int i = 0; i < size; i++)
+        words[(slot + i) >> 6] |= uint64_t(1) << ((slot + i) & 63);
+}
+
+// Return the first free slot at or after the given one.
+int TDefaultIoResolverBase::TSlotSet::nextFree(int slot) const {
+    for (;;) {
+        auto word = words.find(slot >> 6);
+        if (word == words.end())
+            return slot;
+        uint64_t free = ~word->second >> (slot & 63);
+        if (free != 0) {
+            for (; (free & 1) == 0; free >>= 1)
+                ++slot;
+            return slot;
+        }
+        slot = (slot | 63) + 1;
+    }
+}
+
+// Return the lowest slot at or after base that starts size free slots in a row.
+int TDefaultIoResolverBase::TSlotSet::findFree(int base, int size) {
+    if (size <= 0)
+        return base;
+    auto searchStart = searchStarts.find(base);
+    const int firstFree = nextFree(searchStart != searchStarts.end() ? searchStart->second : base);
+    int slot = firstFree;
+    // look for a big enough gap
+    for (int i = 1; i < size; ) {
+        if (isUsed(slot + i)) {
+            slot = nextFree(slot + i + 1);
+            i = 1;
+        } else
+            ++i;
+    }
+    // the caller reserves the slots found
+    searchStarts[base] = slot == firstFree ? slot + size : firstFree;
+    return slot;
 }
 
 bool TDefaultIoResolverBase::checkEmpty(int set, int slot) {
-    TSlotSet::iterator at = findSlot(set, slot);
-    return ! (at != slots[set].end() && *at == slot);
+    return ! slots[set].isUsed(slot);
 }
 
 int TDefaultIoResolverBase::reserveSlot(int set, int slot, int size) {
-    TSlotSet::iterator at = findSlot(set, slot);
     // tolerate aliasing, by not double-recording aliases
     // (policy about appropriateness of the alias is higher up)
-    for (int i = 0; i < size; i++) {
-        if (at == slots[set].end() || *at != slot + i)
-            at = slots[set].insert(at, slot + i);
-        ++at;
-    }
+    slots[set].reserve(slot, size);
     return slot;
 }
 
 int TDefaultIoResolverBase::getFreeSlot(int set, int base, int size) {
-    TSlotSet::iterator at = findSlot(set, base);
-    if (at == slots[set].end())
-        return reserveSlot(set, base, size);
-    // look for a big enough gap
-    for (; at != slots[set].end(); ++at) {
-        if (*at - base >= size)
-            break;
-        base = *at + 1;
-    }
-    return reserveSlot(set, base, size);
+    TSlotSet& slotSet = slots[set];
+    const int slot = slotSet.findFree(base, size);
+    slotSet.reserve(slot, size);
+    return slot;
 }
 
 int TDefaultIoResolverBase::resolveSet(EShLanguage stage, TVarEntryInfo& ent) {
@@ -1542,7 +1583,8 @@ bool TIoMapper::addStage(EShLanguage stage, TIntermediate& intermediate, TInfoSi
 
     TVarLiveMap inVarMap, outVarMap, uniformVarMap;
     TVarLiveVector inVector, outVector, uniformVector;
-    TVarGatherTraverser iter_binding_all(intermediate, true, inVarMap, outVarMap, uniformVarMap);
+    std::vector<TIntermSymbol*> interfaceSymbols;
+    TVarGatherTraverser iter_binding_all(intermediate, true, inVarMap, outVarMap, uniformVarMap, &interfaceSymbols);
     TVarGatherTraverser iter_binding_live(intermediate, false, inVarMap, outVarMap, uniformVarMap);
     root->traverse(&iter_binding_all);
     iter_binding_live.pushFunction(intermediate.getEntryPointMangledName().c_str());
@@ -1597,8 +1639,10 @@ bool TIoMapper::addStage(EShLanguage stage, TIntermediate& intermediate, TInfoSi
     });
     resolver->endResolve(stage);
     if (!hadError) {
+        // set the mapping in the symbols iter_binding_all found, rather than traversing again
         TVarSetTraverser iter_iomap(intermediate, inVarMap, outVarMap, uniformVarMap);
-        root->traverse(&iter_iomap);
+        for (TIntermSymbol* symbol : interfaceSymbols)
+            iter_iomap.visitSymbol(symbol);
     }
     return !hadError;
 }
@@ -1680,8 +1724,9 @@ bool TGlslIoMapper::addStage(EShLanguage stage, TIntermediate& intermediate, TIn
 #endif
     resolver->addStage(stage, intermediate);
     inVarMaps[stage] = new TVarLiveMap(); outVarMaps[stage] = new TVarLiveMap(); uniformVarMap[stage] = new TVarLiveMap();
+    interfaceSymbols[stage].clear();
     TVarGatherTraverser iter_binding_all(intermediate, true, *inVarMaps[stage], *outVarMaps[stage],
-                                         *uniformVarMap[stage]);
+                                         *uniformVarMap[stage], &interfaceSymbols[stage]);
     TVarGatherTraverser iter_binding_live(intermediate, false, *inVarMaps[stage], *outVarMaps[stage],
                                           *uniformVarMap[stage]);
     root->traverse(&iter_binding_all);
@@ -1788,7 +1833,7 @@ bool TGlslIoMapper::doMap(TIoMapResolver* resolver, TInfoSink& infoSink) {
                     auto at = pUniformVarMap[stage]->find(autoPushConstantBlockName);
                     if (at == pUniformVarMap[stage]->end())
                         continue;
-                    TQualifier& qualifier = at->second.symbol->getQualifier();
+                    TQualifier& qualifier = at->second.symbol->getWritableType().getQualifier();
                     if (!qualifier.isUniform())
                         continue;
                     TType& t = at->second.symbol->getWritableType();
@@ -1837,9 +1882,11 @@ bool TGlslIoMapper::doMap(TIoMapResolver* resolver, TInfoSink& infoSink) {
                         }
                     }
                 });
+                // set them in the symbols addStage() found, rather than traversing again
                 TVarSetTraverser iter_iomap(*intermediates[stage], *inVarMaps[stage], *outVarMaps[stage],
                                             *uniformResolve.uniformVarMap[stage]);
-                intermediates[stage]->getTreeRoot()->traverse(&iter_iomap);
+                for (TIntermSymbol* symbol : interfaceSymbols[stage])
+                    iter_iomap.visitSymbol(symbol);
             }
         }
         return !hadError;
@@ -48,12 +48,28 @@ class TInfoSink;
 namespace glslang {
 
 class TIntermediate;
+class TIntermSymbol;
 struct TVarEntryInfo;
 // Base class for shared TIoMapResolver services, used by several derivations.
 struct TDefaultIoResolverBase : public glslang::TIoMapResolver {
 public:
     TDefaultIoResolverBase(const TIntermediate& intermediate);
-    typedef std::vector<int> TSlotSet;
+
+    // The slots used in one set, as a bitmap of 64-slot words.  Slots are never
+    // released, so a search for free slots from a base resumes from the first
+    // free slot the last search from that base found.
+    class TSlotSet {
+    public:
+        bool isUsed(int slot) const;
+        void reserve(int slot, int size);
+        int findFree(int base, int size);
+
+    private:
+        int nextFree(int slot) const;
+
+        std::unordered_map<int, uint64_t> words;   // <slot / 64, a bit per used slot>
+        std::unordered_map<int, int> searchStarts; // <base, slot to resume the search from>
+    };
     typedef std::unordered_map<int, TSlotSet> TSlotSetMap;
 
     // grow the reflection stage by stage
@@ -72,7 +88,6 @@ public:
     virtual TResourceType getResourceType(const glslang::TType& type) = 0;
     bool doAutoBindingMapping() const;
     bool doAutoLocationMapping() const;
-    TSlotSet::iterator findSlot(int set, int slot);
     bool checkEmpty(int set, int slot);
     bool validateInOut(EShLanguage /*stage*/, TVarEntryInfo& /*ent*/) override { return true; }
     int reserveSlot(int set, int slot, int size = 1);
@@ -216,6 +231,8 @@ private:
     TLayoutPacking autoPushConstantBlockPacking;
     TVarLiveMap *inVarMaps[EShLangCount], *outVarMaps[EShLangCount],
                 *uniformVarMap[EShLangCount];
+    // The in/out and uniform symbol nodes of each stage, to set the mapping in
+    std::vector<TIntermSymbol*> interfaceSymbols[EShLangCount];
 };
 
 } // end namespace glslang
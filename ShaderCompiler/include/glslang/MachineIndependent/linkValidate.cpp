@@ -458,17 +458,19 @@ void TIntermediate::optimizeStageIO(TInfoSink&, TIntermediate& unit)
                 if (output->getAsSymbolNode()->getAccessName() == input->getAsSymbolNode()->getAccessName()) {
                     // demote input to a plain variable
                     TIntermSymbol* symbol = input->getAsSymbolNode();
-                    symbol->getQualifier().storage = EvqGlobal;
-                    symbol->getQualifier().clearInterstage();
-                    symbol->getQualifier().clearLayout();
+                    TQualifier& qualifier = symbol->getWritableType().getQualifier();
+                    qualifier.storage = EvqGlobal;
+                    qualifier.clearInterstage();
+                    qualifier.clearLayout();
                 }
             };
 
             // demote all matching outputs to a plain variable
             TIntermSymbol* symbol = output->getAsSymbolNode();
-            symbol->getQualifier().storage = EvqGlobal;
-            symbol->getQualifier().clearInterstage();
-            symbol->getQualifier().clearLayout();
+            TQualifier& qualifier = symbol->getWritableType().getQualifier();
+            qualifier.storage = EvqGlobal;
+            qualifier.clearInterstage();
+            qualifier.clearLayout();
             std::for_each(unitAllInputs.begin(), unitAllInputs.end(), demoteMatchingInputs);
         }
     });
@@ -1048,11 +1050,11 @@ void TIntermediate::mergeLinkerObjects(TInfoSink& infoSink, TIntermSequence& lin
 
                 // Similarly for binding
                 if (! symbol->getQualifier().hasBinding() && unitSymbol->getQualifier().hasBinding())
-                    symbol->getQualifier().layoutBinding = unitSymbol->getQualifier().layoutBinding;
+                    symbol->getWritableType().getQualifier().layoutBinding = unitSymbol->getQualifier().layoutBinding;
 
                 // Similarly for location
                 if (!symbol->getQualifier().hasLocation() && unitSymbol->getQualifier().hasLocation()) {
-                    symbol->getQualifier().layoutLocation = unitSymbol->getQualifier().layoutLocation;
+                    symbol->getWritableType().getQualifier().layoutLocation = unitSymbol->getQualifier().layoutLocation;
                 }
 
                 // Update implicit array sizes
@@ -470,6 +470,7 @@ public:
     void incrementEntryPointCount() { ++numEntryPoints; }
     int getNumEntryPoints() const { return numEntryPoints; }
     int getNumErrors() const { return numErrors; }
+    void setNumErrors(int errors) { numErrors = errors; }
     void addPushConstantCount() { ++numPushConstants; }
     void setLimits(const TBuiltInResource& r) { resources = r; }
     const TBuiltInResource& getLimits() const { return resources; }
@@ -1007,6 +1008,10 @@ public:
     void setBinaryDoubleOutput() { binaryDoubleOutput = true; }
     bool getBinaryDoubleOutput() { return binaryDoubleOutput; }
 
+    // Noted by preprocessing when its text would not scan back to the same tokens
+    void setPreprocessedTextInexact() { preprocessedTextInexact = true; }
+    bool isPreprocessedTextInexact() const { return preprocessedTextInexact; }
+
     void setSubgroupUniformControlFlow() { subgroupUniformControlFlow = true; }
     bool getSubgroupUniformControlFlow() const { return subgroupUniformControlFlow; }
 
@@ -1295,6 +1300,7 @@ protected:
     bool maximallyReconverges;
     bool usePhysicalStorageBuffer;
     bool useReplicatedComposites { false };
+    bool preprocessedTextInexact { false };
 
     TSpirvRequirement* spirvRequirement;
     TSpirvExecutionMode* spirvExecutionMode;
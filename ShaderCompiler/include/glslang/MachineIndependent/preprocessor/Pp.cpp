@@ -164,50 +164,47 @@ int TPpContext::CPPdefine(TPpToken* ppToken)
     // check for duplicate definition
     MacroSymbol* existing = lookupMacroDef(defAtom);
     if (existing != nullptr) {
-        if (! existing->undef) {
-            // Already defined -- need to make sure they are identical:
-            // "Two replacement lists are identical if and only if the
-            // preprocessing tokens in both have the same number,
-            // ordering, spelling, and white-space separation, where all
-            // white-space separations are considered identical."
-            if (existing->functionLike != mac.functionLike) {
-                parseContext.ppError(defineLoc, "Macro redefined; function-like versus object-like:", "#define",
-                    atomStrings.getString(defAtom));
-            } else if (existing->args.size() != mac.args.size()) {
-                parseContext.ppError(defineLoc, "Macro redefined; different number of arguments:", "#define",
-                    atomStrings.getString(defAtom));
-            } else {
-                if (existing->args != mac.args) {
-                    parseContext.ppError(defineLoc, "Macro redefined; different argument names:", "#define",
-                       atomStrings.getString(defAtom));
-                }
-                // set up to compare the two
-                existing->body.reset();
-                mac.body.reset();
-                int newToken;
-                bool firstToken = true;
-                do {
-                    int oldToken;
-                    TPpToken oldPpToken;
-                    TPpToken newPpToken;
-                    oldToken = existing->body.getToken(parseContext, &oldPpToken);
-                    newToken = mac.body.getToken(parseContext, &newPpToken);
-                    // for the first token, preceding spaces don't matter
-                    if (firstToken) {
-                        newPpToken.space = oldPpToken.space;
-                        firstToken = false;
-                    }
-                    if (oldToken != newToken || oldPpToken != newPpToken) {
-                        parseContext.ppError(defineLoc, "Macro redefined; different substitutions:", "#define",
-                            atomStrings.getString(defAtom));
-                        break;
-                    }
-                } while (newToken != EndOfInput);
+        // Already defined -- need to make sure they are identical:
+        // "Two replacement lists are identical if and only if the
+        // preprocessing tokens in both have the same number,
+        // ordering, spelling, and white-space separation, where all
+        // white-space separations are considered identical."
+        if (existing->functionLike != mac.functionLike) {
+            parseContext.ppError(defineLoc, "Macro redefined; function-like versus object-like:", "#define",
+                atomStrings.getString(defAtom));
+        } else if (existing->args.size() != mac.args.size()) {
+            parseContext.ppError(defineLoc, "Macro redefined; different number of arguments:", "#define",
+                atomStrings.getString(defAtom));
+        } else {
+            if (existing->args != mac.args) {
+                parseContext.ppError(defineLoc, "Macro redefined; different argument names:", "#define",
+                   atomStrings.getString(defAtom));
             }
+            // set up to compare the two
+            existing->body.reset();
+            mac.body.reset();
+            int newToken;
+            bool firstToken = true;
+            do {
+                int oldToken;
+                TPpToken oldPpToken;
+                TPpToken newPpToken;
+                oldToken = existing->body.getToken(parseContext, &oldPpToken);
+                newToken = mac.body.getToken(parseContext, &newPpToken);
+                // for the first token, preceding spaces don't matter
+                if (firstToken) {
+                    newPpToken.space = oldPpToken.space;
+                    firstToken = false;
+                }
+                if (oldToken != newToken || oldPpToken != newPpToken) {
+                    parseContext.ppError(defineLoc, "Macro redefined; different substitutions:", "#define",
+                        atomStrings.getString(defAtom));
+                    break;
+                }
+            } while (newToken != EndOfInput);
         }
-        *existing = mac;
-    } else
-        addMacroDef(defAtom, mac);
+    }
+    addMacroDef(defAtom, mac);
 
     return '\n';
 }
@@ -224,9 +221,7 @@ int TPpContext::CPPundef(TPpToken* ppToken)
 
     parseContext.reservedPpErrorCheck(ppToken->loc, ppToken->name, "#undef");
 
-    MacroSymbol* macro = lookupMacroDef(atomStrings.getAtom(ppToken->name));
-    if (macro != nullptr)
-        macro->undef = 1;
+    macroDefs.remove(atomStrings.getAtom(ppToken->name));
     token = scanToken(ppToken);
     if (token != '\n')
         parseContext.ppError(ppToken->loc, "can only be followed by a single macro name", "#undef", "");
@@ -443,8 +438,10 @@ int TPpContext::eval(int token, int precedence, bool shortCircuit, int& res, boo
                 return token;
             }
 
+            if (addTestedMacros)
+                addTestedMacro(ppToken->name);
             MacroSymbol* macro = lookupMacroDef(atomStrings.getAtom(ppToken->name));
-            res = macro != nullptr ? !macro->undef : 0;
+            res = macro != nullptr;
             token = scanToken(ppToken);
             if (needclose) {
                 if (token != ')') {
@@ -538,6 +535,8 @@ int TPpContext::eval(int token, int precedence, bool shortCircuit, int& res, boo
 int TPpContext::evalToToken(int token, bool shortCircuit, int& res, bool& err, TPpToken* ppToken)
 {
     while (token == PpAtomIdentifier && strcmp("defined", ppToken->name) != 0) {
+        if (addTestedMacros)
+            addTestedMacro(ppToken->name);
         switch (MacroExpand(ppToken, true, false)) {
         case MacroExpandNotStarted:
         case MacroExpandError:
@@ -578,7 +577,9 @@ int TPpContext::CPPif(TPpToken* ppToken)
     }
     int res = 0;
     bool err = false;
+    addTestedMacros = dependencies != nullptr;
     token = eval(token, MIN_PRECEDENCE, false, res, err, ppToken);
+    addTestedMacros = false;
     token = extraTokenCheck(PpAtomIf, ppToken, token);
     if (!res && !err)
         token = CPPelse(1, ppToken);
@@ -604,6 +605,8 @@ int TPpContext::CPPifdef(int defined, TPpToken* ppToken)
         else
             parseContext.ppError(ppToken->loc, "must be followed by macro name", "#ifndef", "");
     } else {
+        if (dependencies != nullptr)
+            addTestedMacro(ppToken->name);
         MacroSymbol* macro = lookupMacroDef(atomStrings.getAtom(ppToken->name));
         token = scanToken(ppToken);
         if (token != '\n') {
@@ -611,7 +614,7 @@ int TPpContext::CPPifdef(int defined, TPpToken* ppToken)
             while (token != '\n' && token != EndOfInput)
                 token = scanToken(ppToken);
         }
-        if (((macro != nullptr && !macro->undef) ? 1 : 0) != defined)
+        if ((macro != nullptr ? 1 : 0) != defined)
             token = CPPelse(1, ppToken);
     }
 
@@ -676,6 +679,8 @@ int TPpContext::CPPinclude(TPpToken* ppToken)
 
     // Process the results
     if (res != nullptr && !res->headerName.empty()) {
+        if (dependencies != nullptr && addedIncludes.insert(res->headerName).second)
+            dependencies->includes.push_back(res->headerName);
         if (res->headerData != nullptr && res->headerLength > 0) {
             // path for processing one or more tokens from an included header, hand off 'res'
             const bool forNextLine = parseContext.lineDirectiveShouldSetNextLine();
@@ -685,7 +690,8 @@ int TPpContext::CPPinclude(TPpToken* ppToken)
             epilogue << (res->headerData[res->headerLength - 1] == '\n'? "" : "\n") <<
                 "#line " << directiveLoc.line + forNextLine << " " << directiveLoc.getStringNameOrNum() << "\n";
             pushInput(new TokenizableIncludeFile(directiveLoc, prologue.str(), res, epilogue.str(), this));
-            parseContext.intermediate.addIncludeText(res->headerName.c_str(), res->headerData, res->headerLength);
+            if (! macrosOnly && dependencies == nullptr)
+                parseContext.intermediate.addIncludeText(res->headerName.c_str(), res->headerData, res->headerLength);
             // There's no "current" location anymore.
             parseContext.setCurrentColumn(0);
         } else {
@@ -739,7 +745,8 @@ int TPpContext::CPPline(TPpToken* ppToken)
 
         if (token != '\n') {
             if (token == PpAtomConstString) {
-                parseContext.ppRequireExtensions(directiveLoc, 1, &E_GL_GOOGLE_cpp_style_line_directive, "filename-based #line");
+                if (! macrosOnly)
+                    parseContext.ppRequireExtensions(directiveLoc, 1, &E_GL_GOOGLE_cpp_style_line_directive, "filename-based #line");
                 // We need to save a copy of the string instead of pointing
                 // to the name field of the token since the name field
                 // will likely be overwritten by the next token scan.
@@ -974,13 +981,17 @@ int TPpContext::readCPPline(TPpToken* ppToken)
             token = CPPline(ppToken);
             break;
         case PpAtomInclude:
-            if(!parseContext.isReadingHLSL()) {
+            if(!parseContext.isReadingHLSL() && !macrosOnly) {
                 const std::array exts = { E_GL_GOOGLE_include_directive, E_GL_ARB_shading_language_include };
                 parseContext.ppRequireExtensions(ppToken->loc, exts, "#include");
             }
             token = CPPinclude(ppToken);
             break;
         case PpAtomPragma:
+            if (macrosOnly) {
+                parseContext.ppError(ppToken->loc, "not allowed in a precompiled preamble", "#pragma", "");
+                break;
+            }
             token = CPPpragma(ppToken);
             break;
         case PpAtomUndef:
@@ -990,9 +1001,17 @@ int TPpContext::readCPPline(TPpToken* ppToken)
             token = CPPerror(ppToken);
             break;
         case PpAtomVersion:
+            if (macrosOnly) {
+                parseContext.ppError(ppToken->loc, "not allowed in a precompiled preamble", "#version", "");
+                break;
+            }
             token = CPPversion(ppToken);
             break;
         case PpAtomExtension:
+            if (macrosOnly) {
+                parseContext.ppError(ppToken->loc, "not allowed in a precompiled preamble", "#extension", "");
+                break;
+            }
             token = CPPextension(ppToken);
             break;
         default:
@@ -1194,8 +1213,11 @@ MacroExpandResult TPpContext::MacroExpand(TPpToken* ppToken, bool expandUndef, b
         return MacroExpandStarted;
 
     case PpAtomFileMacro: {
-        if (parseContext.getCurrentLoc().name)
+        if (parseContext.getCurrentLoc().name) {
             parseContext.ppRequireExtensions(ppToken->loc, 1, &E_GL_GOOGLE_cpp_style_line_directive, "filename-based __FILE__");
+            // An integer token spelled as the file name
+            parseContext.intermediate.setPreprocessedTextInexact();
+        }
         ppToken->ival = parseContext.getCurrentLoc().string;
         snprintf(ppToken->name, sizeof(ppToken->name), "%s", ppToken->loc.getStringNameOrNum().c_str());
         UngetToken(PpAtomConstInt, ppToken);
@@ -1221,11 +1243,11 @@ MacroExpandResult TPpContext::MacroExpand(TPpToken* ppToken, bool expandUndef, b
     }
 
     // not expanding undefined macros
-    if ((macro == nullptr || macro->undef) && ! expandUndef)
+    if (macro == nullptr && ! expandUndef)
         return MacroExpandNotStarted;
 
     // 0 is the value of an undefined macro
-    if ((macro == nullptr || macro->undef) && expandUndef) {
+    if (macro == nullptr && expandUndef) {
         pushInput(new tZeroInput(this));
         return MacroExpandUndef;
     }
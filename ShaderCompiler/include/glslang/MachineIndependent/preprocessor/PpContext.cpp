@@ -89,7 +89,10 @@ TPpContext::TPpContext(TParseContextBase& pc, const std::string& rootFileName, T
     rootFileName(rootFileName),
     currentSourceFile(rootFileName),
     disableEscapeSequences(false),
-    inElseSkip(false)
+    inElseSkip(false),
+    macrosOnly(false),
+    dependencies(nullptr),
+    addTestedMacros(false)
 {
     ifdepth = 0;
     for (elsetracker = 0; elsetracker < maxIfNesting; elsetracker++)
@@ -118,4 +121,74 @@ void TPpContext::setInput(TInputScanner& input, bool versionWillBeError)
     versionSeen = false;
 }
 
+bool TPpContext::captureMacros(TPpMacroSet& macroSet)
+{
+    const TMacroTable existing = macroDefs;
+
+    const int numErrors = parseContext.getNumErrors();
+    macrosOnly = true;
+    TPpToken ppToken;
+    if (tokenize(ppToken) != EndOfInput)
+        parseContext.ppError(ppToken.loc, "only preprocessor directives are allowed in a precompiled preamble", ppToken.name, "");
+    macrosOnly = false;
+    while (! inputStack.empty())
+        popInput();
+
+    for (int atom = 0; atom < macroDefs.atomLimit(); ++atom) {
+        const MacroSymbol* symbol = macroDefs.find(atom);
+        if (existing.find(atom) != nullptr) {
+            if (symbol == nullptr)
+                parseContext.ppError(ppToken.loc, "cannot be undefined by a precompiled preamble", "#undef",
+                                     atomStrings.getString(atom));
+            continue;
+        }
+        if (symbol == nullptr)
+            continue;
+
+        TPpMacroSet::Macro macro;
+        macro.name = atomStrings.getString(atom);
+        for (int arg : symbol->args)
+            macro.args.push_back(atomStrings.getString(arg));
+        macro.body.reserve(symbol->body.size());
+        for (size_t t = 0; t < symbol->body.size(); ++t) {
+            TPpToken token;
+            const int tokenAtom = symbol->body.getRawToken(t, token);
+            macro.body.push_back({ tokenAtom, token.space, token.i64val, token.name });
+        }
+        macro.functionLike = symbol->functionLike;
+        macroSet.macros.push_back(std::move(macro));
+    }
+
+    return parseContext.getNumErrors() == numErrors;
+}
+
+void TPpContext::installMacros(const TPpMacroSet& macroSet)
+{
+    for (const TPpMacroSet::Macro& macro : macroSet.macros) {
+        MacroSymbol symbol;
+        for (const std::string& arg : macro.args)
+            symbol.args.push_back(atomStrings.getAddAtom(arg.c_str()));
+        for (const TPpMacroSet::Token& token : macro.body) {
+            TPpToken ppToken;
+            ppToken.space = token.space;
+            ppToken.i64val = token.i64val;
+            snprintf(ppToken.name, sizeof(ppToken.name), "%s", token.name.c_str());
+            symbol.body.putToken(token.atom, &ppToken);
+        }
+        symbol.functionLike = macro.functionLike;
+        addMacroDef(atomStrings.getAddAtom(macro.name.c_str()), symbol);
+    }
+}
+
+void TPpContext::scanDependencies(TShader::Dependencies& found)
+{
+    dependencies = &found;
+    TPpToken ppToken;
+    while (tokenize(ppToken) != EndOfInput)
+        ;
+    dependencies = nullptr;
+    addedIncludes.clear();
+    addedMacros.clear();
+}
+
 } // end namespace glslang
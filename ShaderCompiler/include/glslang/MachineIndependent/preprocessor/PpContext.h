@@ -81,6 +81,7 @@ NVIDIA HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <stack>
 #include <unordered_map>
+#include <unordered_set>
 #include <sstream>
 
 #include "../ParseHelper.h"
@@ -183,6 +184,25 @@ protected:
 
 class TInputScanner;
 
+// Macro definitions captured from one TPpContext, to be installed into others.
+// Nothing here refers to a context's atoms or memory pool, so a set can
+// outlive the compile that built it and be shared between threads.
+struct TPpMacroSet {
+    struct Token {
+        int atom;          // token kind; never a context-specific atom
+        bool space;
+        long long i64val;
+        std::string name;
+    };
+    struct Macro {
+        std::string name;
+        std::vector<std::string> args;
+        std::vector<Token> body;
+        bool functionLike;
+    };
+    std::vector<Macro> macros;
+};
+
 enum MacroExpandResult {
     MacroExpandNotStarted, // macro not expanded, which might not be an error
     MacroExpandError,      // a clear error occurred while expanding, no expansion
@@ -228,6 +248,19 @@ public:
 
     void setInput(TInputScanner& input, bool versionWillBeError);
 
+    // Run the current input, which may hold nothing but preprocessor directives,
+    // and add every macro it leaves defined to 'macroSet'.  Macros defined before
+    // the call are not captured and may not be #undef'd.
+    // Returns false if an error was reported.
+    bool captureMacros(TPpMacroSet& macroSet);
+    // Define every macro in 'macroSet'.  Nothing checks them against macros
+    // already defined, so this is for use before any input is scanned.
+    void installMacros(const TPpMacroSet& macroSet);
+    // Run the current input for TShader::scanDependencies(): only the
+    // directives take effect, and what they include and test is added to
+    // 'found'.
+    void scanDependencies(TShader::Dependencies& found);
+
     void pushInput(tInput* in)
     {
         inputStack.push_back(in);
@@ -248,20 +281,25 @@ public:
     class TokenStream {
     public:
         // Manage a stream of these 'Token', which capture the relevant parts
-        // of a TPpToken, plus its atom.
+        // of a TPpToken, plus its atom.  The token text is not held by the
+        // token itself but appended to the stream's 'names' buffer, so a token
+        // is a small fixed-size record and recording one allocates nothing of
+        // its own.
         class Token {
         public:
-            Token(int atom, const TPpToken& ppToken) : 
+            Token(int atom, const TPpToken& ppToken, size_t nameOffset, size_t nameLength) :
                 atom(atom),
                 space(ppToken.space),
-                i64val(ppToken.i64val),
-                name(ppToken.name) { }
-            int get(TPpToken& ppToken)
+                nameLength((unsigned int)nameLength),
+                nameOffset(nameOffset),
+                i64val(ppToken.i64val) { }
+            int get(TPpToken& ppToken, const char* names) const
             {
                 ppToken.clear();
                 ppToken.space = space;
                 ppToken.i64val = i64val;
-                snprintf(ppToken.name, sizeof(ppToken.name), "%s", name.c_str());
+                memcpy(ppToken.name, names + nameOffset, nameLength);
+                ppToken.name[nameLength] = 0;
                 return atom;
             }
             bool isAtom(int a) const { return atom == a; }
@@ -271,8 +309,9 @@ public:
             Token() {}
             int atom;
             bool space;        // did a space precede the token?
+            unsigned int nameLength;
+            size_t nameOffset; // into the owning stream's 'names'
             long long i64val;
-            TString name;
         };
 
         TokenStream() : currentPos(0) { }
@@ -313,9 +352,12 @@ public:
         bool peekTokenizedPasting(bool lastTokenPastes);
         bool peekUntokenizedPasting();
         void reset() { currentPos = 0; }
+        size_t size() const { return stream.size(); }
+        int getRawToken(size_t index, TPpToken& ppToken) const { return stream[index].get(ppToken, names.data()); }
 
     protected:
         TVector<Token> stream;
+        TString names;     // the text of all tokens in 'stream', back to back
         size_t currentPos;
     };
 
@@ -324,22 +366,49 @@ public:
     //
 
     struct MacroSymbol {
-        MacroSymbol() : functionLike(0), busy(0), undef(0) { }
+        POOL_ALLOCATOR_NEW_DELETE(GetThreadPoolAllocator())
+
+        MacroSymbol() : functionLike(0), busy(0) { }
         TVector<int> args;
         TokenStream body;
         unsigned functionLike : 1;  // 0 means object-like, 1 means function-like
         unsigned busy         : 1;
-        unsigned undef        : 1;
     };
 
-    typedef TMap<int, MacroSymbol> TSymbolMap;
-    TSymbolMap macroDefs;  // map atoms to macro definitions
-    MacroSymbol* lookupMacroDef(int atom)
-    {
-        auto existingMacroIt = macroDefs.find(atom);
-        return (existingMacroIt == macroDefs.end()) ? nullptr : &(existingMacroIt->second);
-    }
-    void addMacroDef(int atom, MacroSymbol& macroDef) { macroDefs[atom] = macroDef; }
+    // Map atoms to macro definitions.  Atoms are small contiguous integers, so
+    // the table is indexed directly by atom: a lookup is a bounds check and a
+    // load.  A definition is never changed once added (apart from 'busy' while
+    // it is being expanded); #define and #undef replace or drop the entry
+    // instead.  So a MacroSymbol* stays valid across later definitions, and a
+    // copy of the table is a snapshot of the macros defined at that point,
+    // costing one pointer per atom; assigning it back restores them.
+    class TMacroTable {
+    public:
+        MacroSymbol* find(int atom) const
+        {
+            return atom > 0 && atom < (int)symbols.size() ? symbols[atom] : nullptr;
+        }
+        void add(int atom, const MacroSymbol& macroDef)
+        {
+            if (atom >= (int)symbols.size())
+                symbols.resize(atom + 1, nullptr);
+            symbols[atom] = new MacroSymbol(macroDef);
+        }
+        void remove(int atom)
+        {
+            if (atom > 0 && atom < (int)symbols.size())
+                symbols[atom] = nullptr;
+        }
+        // One more than the largest atom that may have a definition.
+        int atomLimit() const { return (int)symbols.size(); }
+
+    protected:
+        TVector<MacroSymbol*> symbols;
+    };
+
+    TMacroTable macroDefs;
+    MacroSymbol* lookupMacroDef(int atom) { return macroDefs.find(atom); }
+    void addMacroDef(int atom, MacroSymbol& macroDef) { macroDefs.add(atom, macroDef); }
 
 protected:
     TPpContext(TPpContext&);
@@ -735,6 +804,22 @@ protected:
     // True if we're skipping a section enclosed by #if/#ifdef/#elif/#else which was evaluated to
     // be inactive, e.g. #if 0
     bool inElseSkip;
+    // True while captureMacros() runs: directives with effects beyond macro
+    // definitions are rejected, and #include needs no extension.
+    bool macrosOnly;
+
+    // While scanDependencies() runs, where to add what the input depends on,
+    // and what was added already.
+    TShader::Dependencies* dependencies;
+    std::unordered_set<std::string> addedIncludes;
+    std::unordered_set<std::string> addedMacros;
+    // True while scanDependencies() evaluates a #if or #elif condition.
+    bool addTestedMacros;
+    void addTestedMacro(const char* name)
+    {
+        if (addedMacros.insert(name).second)
+            dependencies->testedMacros.push_back(name);
+    }
 };
 
 } // end namespace glslang
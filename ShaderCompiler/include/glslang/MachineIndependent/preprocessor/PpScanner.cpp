@@ -485,6 +485,7 @@ int TPpContext::tStringInput::scan(TPpToken* ppToken)
     for (;;) {
         while (ch == ' ' || ch == '\t') {
             ppToken->space = true;
+            input->consumeRun(TInputScanner::ERunSpaceTab);
             ch = getch();
         }
 
@@ -512,6 +513,8 @@ int TPpContext::tStringInput::scan(TPpToken* ppToken)
             do {
                 if (len < MaxTokenLength) {
                     ppToken->name[len++] = (char)ch;
+                    len += (int)input->consumeRun(TInputScanner::ERunIdentifier, ppToken->name + len,
+                                                  MaxTokenLength - len);
                     ch = getch();
                 } else {
                     if (! AlreadyComplained) {
@@ -1085,6 +1088,7 @@ int TPpContext::tStringInput::scan(TPpToken* ppToken)
             if (ch == '/') {
                 pp->inComment = true;
                 do {
+                    input->consumeRun(TInputScanner::ERunLineComment);
                     ch = getch();
                 } while (ch != '\n' && ch != EndOfInput);
                 ppToken->space = true;
@@ -1099,6 +1103,7 @@ int TPpContext::tStringInput::scan(TPpToken* ppToken)
                             pp->parseContext.ppError(ppToken->loc, "End of input in comment", "comment", "");
                             return ch;
                         }
+                        input->consumeRun(TInputScanner::ERunBlockComment);
                         ch = getch();
                     }
                     ch = getch();
@@ -1254,6 +1259,10 @@ int TPpContext::tokenize(TPpToken& ppToken)
         if (token == '\n')
             continue;
 
+        // only directives matter when scanning dependencies
+        if (dependencies != nullptr)
+            continue;
+
         // expand macros
         if (token == PpAtomIdentifier) {
             switch (MacroExpand(&ppToken, false, true)) {
@@ -100,8 +100,9 @@ namespace glslang {
 // token stream, for later playback.
 void TPpContext::TokenStream::putToken(int atom, TPpToken* ppToken)
 {
-    TokenStream::Token streamToken(atom, *ppToken);
-    stream.push_back(streamToken);
+    const size_t nameLength = strlen(ppToken->name);
+    stream.push_back(TokenStream::Token(atom, *ppToken, names.size(), nameLength));
+    names.append(ppToken->name, nameLength);
 }
 
 // Read the next token from a macro token stream.
@@ -110,7 +111,7 @@ int TPpContext::TokenStream::getToken(TParseContextBase& parseContext, TPpToken
     if (atEnd())
         return EndOfInput;
 
-    int atom = stream[currentPos++].get(*ppToken);
+    int atom = stream[currentPos++].get(*ppToken, names.data());
     ppToken->loc = parseContext.getCurrentLoc();
 
     // Check for ##, unless the current # is the last character
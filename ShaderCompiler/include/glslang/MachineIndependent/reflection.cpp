@@ -40,6 +40,9 @@
 
 #include "gl_types.h"
 
+#include <string>
+#include <unordered_map>
+
 //
 // Grow the reflection database through a friend traverser class of TReflection and a
 // collection of functions to do a liveness traversal that note what uniforms are used
@@ -1293,4 +1296,275 @@ void TReflection::dump()
     // printf("\n");
 }
 
+//
+// Resource layout implementation.
+//
+// Every linker object of a stage that is a resource or a user-defined input or output
+// becomes a TResourceLayout::TResource.  Block members are laid out as SPIR-V
+// generation does, one offset after the other, following
+// TGlslangToSpvTraverser::updateMemberOffset().
+//
+
+namespace {
+
+class TResourceLayoutBuilder {
+public:
+    explicit TResourceLayoutBuilder(TResourceLayout& layout) : layout(layout) { layout.clear(); }
+
+    void addStage(EShLanguage stage, const TIntermediate& intermediate)
+    {
+        vulkan = intermediate.getSpv().vulkan > 0;
+        hlslOffsets = intermediate.usingHlslOffsets();
+        const TIntermSequence& linkerObjects = intermediate.findLinkerObjects()->getSequence();
+        for (size_t i = 0; i < linkerObjects.size(); ++i) {
+            const TIntermSymbol* symbol = linkerObjects[i]->getAsSymbolNode();
+            if (symbol != nullptr)
+                addSymbol(stage, *symbol);
+        }
+    }
+
+protected:
+    void addSymbol(EShLanguage stage, const TIntermSymbol& symbol)
+    {
+        const TType& type = symbol.getType();
+        const TQualifier& qualifier = type.getQualifier();
+        if (type.isBuiltIn() || (type.isStruct() && (*type.getStruct())[0].type->isBuiltIn()))
+            return;
+
+        TResourceLayout::EKind kind;
+        if (qualifier.storage == EvqVaryingIn)
+            kind = TResourceLayout::EKindInput;
+        else if (qualifier.storage == EvqVaryingOut)
+            kind = TResourceLayout::EKindOutput;
+        else if (qualifier.isUniformOrBuffer()) {
+            if (! getResourceKind(type, kind))
+                return;
+        } else
+            return;
+
+        const bool isIo = kind == TResourceLayout::EKindInput || kind == TResourceLayout::EKindOutput;
+        const bool isDescriptor = ! isIo && kind != TResourceLayout::EKindPushConstant && kind != TResourceLayout::EKindUniform;
+        const int set = qualifier.hasSet() ? (int)qualifier.layoutSet : (isDescriptor && vulkan ? 0 : -1);
+        const int binding = qualifier.hasBinding() ? (int)qualifier.layoutBinding : -1;
+        const TString& name = type.getBasicType() == EbtBlock ? type.getTypeName() : symbol.getName();
+
+        // The same resource declared by several stages is listed once
+        if (! isIo) {
+            int* index;
+            if (binding >= 0)
+                index = &bindingToIndex[((unsigned long long)(unsigned int)set << 32) | (unsigned int)binding];
+            else
+                index = &nameToIndex[std::string(name.c_str(), name.size())];
+            if (*index > 0) {
+                layout.resources[*index - 1].stages = (EShLanguageMask)(layout.resources[*index - 1].stages | (1 << stage));
+                return;
+            }
+            *index = (int)layout.resources.size() + 1;
+        }
+
+        TResourceLayout::TResource resource;
+        resource.name = addName(name);
+        resource.kind = kind;
+        resource.stages = (EShLanguageMask)(1 << stage);
+        resource.set = set;
+        resource.binding = binding;
+        if (kind == TResourceLayout::EKindInputAttachment)
+            resource.location = qualifier.hasAttachment() ? (int)qualifier.layoutAttachment : -1;
+        else
+            resource.location = qualifier.hasLocation() ? (int)qualifier.layoutLocation : -1;
+        resource.component = qualifier.hasComponent() ? (int)qualifier.layoutComponent : -1;
+        resource.arraySize = type.isArray() ? (type.isSizedArray() ? type.getCumulativeArraySize() : 0) : 1;
+        setNumeric(type, resource);
+        resource.size = -1;
+        resource.firstMember = -1;
+        resource.numMembers = 0;
+        if (type.getBasicType() == EbtBlock && ! isIo) {
+            resource.numMembers = (int)type.getStruct()->size();
+            resource.firstMember = addMembers(type, qualifier.layoutPacking, qualifier.layoutMatrix == ElmRowMajor,
+                                              resource.size);
+        }
+        layout.resources.push_back(resource);
+    }
+
+    // What kind of resource a uniform or buffer of the type is; false if it is none to list
+    static bool getResourceKind(const TType& type, TResourceLayout::EKind& kind)
+    {
+        const TQualifier& qualifier = type.getQualifier();
+        switch (type.getBasicType()) {
+        case EbtBlock:
+            if (qualifier.isShaderRecord())
+                return false;
+            if (qualifier.isPushConstant())
+                kind = TResourceLayout::EKindPushConstant;
+            else if (qualifier.storage == EvqBuffer)
+                kind = TResourceLayout::EKindStorageBuffer;
+            else
+                kind = TResourceLayout::EKindUniformBuffer;
+            return true;
+        case EbtSampler:
+        {
+            const TSampler& sampler = type.getSampler();
+            if (sampler.isAttachmentEXT() || sampler.isTileAttachmentQCOM())
+                return false;
+            if (sampler.isPureSampler())
+                kind = TResourceLayout::EKindSampler;
+            else if (sampler.isSubpass())
+                kind = TResourceLayout::EKindInputAttachment;
+            else if (sampler.isImage())
+                kind = sampler.isBuffer() ? TResourceLayout::EKindStorageTexelBuffer : TResourceLayout::EKindStorageImage;
+            else if (sampler.isBuffer())
+                kind = TResourceLayout::EKindUniformTexelBuffer;
+            else if (sampler.isCombined())
+                kind = TResourceLayout::EKindCombinedImageSampler;
+            else
+                kind = TResourceLayout::EKindSampledImage;
+            return true;
+        }
+        case EbtAccStruct:
+            kind = TResourceLayout::EKindAccelerationStructure;
+            return true;
+        default:
+            kind = TResourceLayout::EKindUniform;
+            return qualifier.storage == EvqUniform;
+        }
+    }
+
+    // Add the members of the block or struct type, laid out with the packing of its block, and
+    // return the index of the first; size is set to where the last one ends
+    int addMembers(const TType& type, TLayoutPacking packing, bool rowMajor, int& size)
+    {
+        const TTypeList& memberList = *type.getStruct();
+        const int first = (int)layout.members.size();
+        layout.members.resize(first + memberList.size());
+
+        int offset = 0;
+        for (size_t m = 0; m < memberList.size(); ++m) {
+            const TType& memberType = *memberList[m].type;
+            const TQualifier& qualifier = memberType.getQualifier();
+            const bool memberRowMajor = qualifier.layoutMatrix != ElmNone ? qualifier.layoutMatrix == ElmRowMajor : rowMajor;
+
+            // if the user supplied an offset, snap to it now
+            if (qualifier.hasOffset())
+                offset = qualifier.layoutOffset;
+            int memberSize;
+            int stride;
+            int memberAlignment = TIntermediate::getMemberAlignment(memberType, memberSize, stride, packing, memberRowMajor);
+
+            bool isVectorLike = memberType.isVector();
+            if (memberType.isMatrix())
+                isVectorLike = (memberRowMajor ? memberType.getMatrixRows() : memberType.getMatrixCols()) == 1;
+
+            // Adjust alignment and size for HLSL rules, except in $Global, as SPIR-V generation does
+            if (hlslOffsets && ! memberType.isStruct() && type.getTypeName().compare("$Global") != 0) {
+                int componentSize;
+                int componentAlignment = TIntermediate::getBaseAlignmentScalar(memberType, componentSize);
+                if (! memberType.isArray() && isVectorLike && componentAlignment <= 4)
+                    memberAlignment = componentAlignment;
+
+                // undo std140 bumping size to a multiple of vec4
+                if (packing == ElpStd140) {
+                    if (memberType.isMatrix())
+                        memberSize -= componentSize * (4 - (memberRowMajor ? memberType.getMatrixCols() : memberType.getMatrixRows()));
+                    else if (memberType.isArray())
+                        memberSize -= componentSize * (4 - memberType.getVectorSize());
+                }
+            }
+
+            RoundToPow2(offset, memberAlignment);
+
+            // bump up to vec4 if there is a bad straddle
+            if (packing != ElpScalar && TIntermediate::improperStraddle(memberType, memberSize, offset, isVectorLike))
+                RoundToPow2(offset, 16);
+
+            TResourceLayout::TMember member;
+            member.name = addName(memberType.getFieldName());
+            member.offset = offset;
+            member.size = memberSize;
+            member.arraySize = memberType.isArray() ? memberType.getOuterArraySize() : 1;
+            member.arrayStride = memberType.isArray() ? stride : 0;
+            member.matrixStride = 0;
+            if (memberType.isMatrix() && memberType.isArray()) {
+                TType elementType(memberType, 0);
+                int elementSize;
+                TIntermediate::getMemberAlignment(elementType, elementSize, member.matrixStride, packing, memberRowMajor);
+            } else if (memberType.isMatrix())
+                member.matrixStride = stride;
+            member.rowMajor = memberType.isMatrix() && memberRowMajor;
+            setNumeric(memberType, member);
+            member.firstMember = -1;
+            member.numMembers = 0;
+            if (memberType.isStruct()) {
+                int structSize;
+                member.numMembers = (int)memberType.getStruct()->size();
+                member.firstMember = addMembers(memberType, packing, memberRowMajor, structSize);
+            }
+            layout.members[first + m] = member;
+
+            offset += memberSize;
+        }
+        size = offset;
+
+        return first;
+    }
+
+    template<class TRecord>
+    static void setNumeric(const TType& type, TRecord& record)
+    {
+        record.numeric = TResourceLayout::ENumericNone;
+        record.width = -1;
+        record.vectorSize = -1;
+        record.matrixColumns = 0;
+        switch (type.getBasicType()) {
+        case EbtFloat:      record.numeric = TResourceLayout::ENumericFloat; record.width = 32; break;
+        case EbtDouble:     record.numeric = TResourceLayout::ENumericFloat; record.width = 64; break;
+        case EbtFloat16:
+        case EbtBFloat16:   record.numeric = TResourceLayout::ENumericFloat; record.width = 16; break;
+        case EbtFloatE5M2:
+        case EbtFloatE4M3:  record.numeric = TResourceLayout::ENumericFloat; record.width = 8;  break;
+        case EbtInt8:       record.numeric = TResourceLayout::ENumericInt;   record.width = 8;  break;
+        case EbtInt16:      record.numeric = TResourceLayout::ENumericInt;   record.width = 16; break;
+        case EbtInt:        record.numeric = TResourceLayout::ENumericInt;   record.width = 32; break;
+        case EbtInt64:      record.numeric = TResourceLayout::ENumericInt;   record.width = 64; break;
+        case EbtUint8:      record.numeric = TResourceLayout::ENumericUint;  record.width = 8;  break;
+        case EbtUint16:     record.numeric = TResourceLayout::ENumericUint;  record.width = 16; break;
+        case EbtUint:       record.numeric = TResourceLayout::ENumericUint;  record.width = 32; break;
+        case EbtUint64:     record.numeric = TResourceLayout::ENumericUint;  record.width = 64; break;
+        case EbtBool:       record.numeric = TResourceLayout::ENumericBool;  record.width = 32; break;
+        default:
+            return;
+        }
+        if (type.isMatrix()) {
+            record.vectorSize = type.getMatrixRows();
+            record.matrixColumns = type.getMatrixCols();
+        } else
+            record.vectorSize = type.getVectorSize();
+    }
+
+    int addName(const TString& name)
+    {
+        const int offset = (int)layout.names.size();
+        layout.names.append(name.c_str(), name.size());
+        layout.names.push_back('\0');
+        return offset;
+    }
+
+    TResourceLayout& layout;
+    bool vulkan = false;
+    bool hlslOffsets = false;
+    // 1 + the index of a resource in layout.resources
+    std::unordered_map<unsigned long long, int> bindingToIndex;
+    std::unordered_map<std::string, int> nameToIndex;
+};
+
+} // end anonymous namespace
+
+void BuildResourceLayout(const TIntermediate* const intermediates[EShLangCount], TResourceLayout& layout)
+{
+    TResourceLayoutBuilder builder(layout);
+    for (int s = 0; s < EShLangCount; ++s) {
+        if (intermediates[s] != nullptr)
+            builder.addStage((EShLanguage)s, *intermediates[s]);
+    }
+}
+
 } // end namespace glslang
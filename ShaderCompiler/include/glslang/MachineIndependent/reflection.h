@@ -221,6 +221,9 @@ protected:
     unsigned int tileShadingRateQCOM[3];
 };
 
+// Fill in layout from the linker objects of the stages of a program; stages without an intermediate are skipped
+void BuildResourceLayout(const TIntermediate* const intermediates[EShLangCount], TResourceLayout& layout);
+
 } // end namespace glslang
 
 #endif // _REFLECTION_INCLUDED
@@ -446,11 +446,46 @@ enum TBlockStorageClass
     EbsCount,
 };
 
+// A precompiled preamble is a header set, e.g. "#include \"common.glsl\"",
+// shared by many shaders that may only define macros.  Each TShader it is
+// given to starts out with the macros the header set leaves defined, but the
+// header set itself is preprocessed only once per source language, version,
+// and profile, rather than once per shader.
+//
+// The header set sees the built-in macros only: neither the TShader's own
+// preamble nor its source can affect it.  #version, #extension, and #pragma
+// are errors, as is anything that is not a preprocessor directive.
+//
+// Thread safe: one instance can be used by many TShaders at once.
+//
+class TPrecompiledPreamble {
+public:
+    GLSLANG_EXPORT TPrecompiledPreamble(const char* text, size_t length, const char* name);
+    GLSLANG_EXPORT ~TPrecompiledPreamble();
+
+    const std::string& getText() const { return text; }
+    const std::string& getName() const { return name; }
+
+    // For use by the implementation.
+    struct TMacroSets;
+    TMacroSets& getMacroSets() const { return *macroSets; }
+
+private:
+    TPrecompiledPreamble(const TPrecompiledPreamble&);
+    TPrecompiledPreamble& operator=(const TPrecompiledPreamble&);
+
+    std::string text;
+    std::string name;
+    TMacroSets* macroSets;
+};
+
 // Make one TShader per shader that you will link into a program. Then
 //  - provide the shader through setStrings() or setStringsWithLengths()
 //  - optionally call setEnv*(), see below for more detail
 //  - optionally use setPreamble() to set a special shader string that will be
 //    processed before all others but won't affect the validity of #version
+//  - optionally use setPrecompiledPreamble() to start with the macros of a
+//    shared header set, see class TPrecompiledPreamble
 //  - optionally call addProcesses() for each setting/transform,
 //    see comment for class TProcesses
 //  - call parse(): source language and target environment must be selected
@@ -473,6 +508,7 @@ public:
     GLSLANG_EXPORT void setStringsWithLengthsAndNames(
         const char* const* s, const int* l, const char* const* names, int n);
     void setPreamble(const char* s) { preamble = s; }
+    void setPrecompiledPreamble(TPrecompiledPreamble* p) { precompiledPreamble = p; }
     GLSLANG_EXPORT void setEntryPoint(const char* entryPoint);
     GLSLANG_EXPORT void setSourceEntryPoint(const char* sourceEntryPointName);
     GLSLANG_EXPORT void addProcesses(const std::vector<std::string>&);
@@ -696,6 +732,54 @@ public:
         bool forwardCompatible, EShMessages message, std::string* outputString,
         Includer& includer);
 
+    // Receives the text produced by the streaming form of preprocess().
+    class PreprocessedTextSink {
+    public:
+        // Called with the next piece of preprocessed text.  Pieces are
+        // produced in order, and split at arbitrary points.
+        virtual void write(const char* text, size_t length) = 0;
+        virtual ~PreprocessedTextSink() {}
+    };
+
+    // Like preprocess() above, but instead of building the whole preprocessed
+    // text as one string, hands it to 'outputSink' in pieces as it is
+    // produced, holding at most a piece's worth at a time.  Text is written
+    // even when preprocessing fails, so whether it is usable is known only from
+    // the return value.
+    GLSLANG_EXPORT bool preprocess(
+        const TBuiltInResource* builtInResources, int defaultVersion,
+        EProfile defaultProfile, bool forceDefaultVersionAndProfile,
+        bool forwardCompatible, EShMessages message, PreprocessedTextSink& outputSink,
+        Includer& includer);
+
+    // After preprocess(), whether parsing its text would see the same tokens as
+    // parsing the shader itself.  It would not if a string was written out with
+    // its escape sequences decoded, or __FILE__ as a bare file name.
+    GLSLANG_EXPORT bool isPreprocessedTextExact() const;
+
+    // What a shader's preprocessed form depends on, as found by
+    // scanDependencies().
+    struct Dependencies {
+        // Header names of the files included, as resolved by the includer,
+        // each once, in the order first included.
+        std::vector<std::string> includes;
+        // Macros tested by #if, #elif, #ifdef, #ifndef or defined(), each
+        // once, in the order first tested.  Includes macros tested only
+        // within the expansion of another.
+        std::vector<std::string> testedMacros;
+    };
+
+    // Finds the files the shader includes and the macros its conditional
+    // directives test, like preprocess() but running only the preprocessor
+    // directives: other tokens are skipped without macro expansion, and so
+    // are conditional blocks that are not taken.  Returns false if an error
+    // was reported, in which case 'dependencies' may be incomplete.
+    GLSLANG_EXPORT bool scanDependencies(
+        const TBuiltInResource* builtInResources, int defaultVersion,
+        EProfile defaultProfile, bool forceDefaultVersionAndProfile,
+        bool forwardCompatible, EShMessages message, Includer& includer,
+        Dependencies& dependencies);
+
     GLSLANG_EXPORT const char* getInfoLog();
     GLSLANG_EXPORT const char* getInfoDebugLog();
     EShLanguage getStage() const { return stage; }
@@ -721,6 +805,7 @@ protected:
     const char* const* stringNames;
     int numStrings;                  // size of the above arrays
     const char* preamble;            // string of implicit code to compile before the explicitly provided code
+    TPrecompiledPreamble* precompiledPreamble;  // macros defined before even the preamble, not owned
 
     // a function in the source string can be renamed FROM this TO the name given in setEntryPoint.
     std::string sourceEntryPointName;
@@ -777,6 +862,90 @@ protected:
     const TType* type;
 };
 
+//
+// The resources and user-defined inputs and outputs of a program, as mapIO()
+// left their bindings and locations: what a pipeline layout is made from.
+// Unlike the reflection database, it is read from the linker objects of each
+// stage rather than by traversing the linked trees again, so it lists what is
+// declared, whether or not it is used.
+//
+// Names are offsets into names, where each ends with a NUL.  Sizes, offsets
+// and strides are in bytes.  A field that does not apply is -1, unless noted.
+//
+struct TResourceLayout {
+    enum EKind {
+        EKindUniformBuffer,
+        EKindStorageBuffer,
+        EKindPushConstant,
+        EKindSampler,
+        EKindSampledImage,
+        EKindCombinedImageSampler,
+        EKindStorageImage,
+        EKindUniformTexelBuffer,
+        EKindStorageTexelBuffer,
+        EKindInputAttachment,
+        EKindAccelerationStructure,
+        EKindUniform,               // a uniform outside of a block, e.g. for OpenGL
+        EKindInput,
+        EKindOutput,
+    };
+
+    // What the components of a scalar, vector or matrix are
+    enum ENumeric {
+        ENumericNone,               // not a scalar, vector or matrix
+        ENumericFloat,
+        ENumericInt,
+        ENumericUint,
+        ENumericBool,
+    };
+
+    // A member of a block, or a field of a struct member, at an offset from the start of what contains it
+    struct TMember {
+        int name;
+        int offset;
+        int size;                   // of the whole array, for an array; one element for one sized at run time
+        int arraySize;              // elements of the outermost dimension; 1 if not an array, 0 if sized at run time
+        int arrayStride;            // 0 if not an array
+        int matrixStride;           // 0 if not a matrix
+        bool rowMajor;
+        ENumeric numeric;
+        int width;                  // bits per component
+        int vectorSize;             // of a vector, or of each column of a matrix
+        int matrixColumns;          // 0 if not a matrix
+        int firstMember;            // of a struct, its fields are numMembers entries of members from here
+        int numMembers;
+    };
+
+    struct TResource {
+        int name;                   // of the block, rather than of its instance
+        EKind kind;
+        EShLanguageMask stages;     // that declare it
+        int set;
+        int binding;
+        int location;               // of an input, output or loose uniform; the index of an input attachment
+        int component;
+        int arraySize;              // elements of all dimensions; 1 if not an array, 0 if sized at run time
+        int size;                   // of the data of a block, with one element of an array sized at run time
+        ENumeric numeric;           // the type of a non-block, as for TMember
+        int width;
+        int vectorSize;
+        int matrixColumns;
+        int firstMember;            // of a block, its members are numMembers entries of members from here
+        int numMembers;
+    };
+
+    void clear()
+    {
+        resources.clear();
+        members.clear();
+        names.clear();
+    }
+
+    std::vector<TResource> resources;
+    std::vector<TMember> members;
+    std::string names;
+};
+
 class  TReflection;
 class  TIoMapper;
 struct TVarEntryInfo;
@@ -883,6 +1052,23 @@ public:
     GLSLANG_EXPORT virtual ~TProgram();
     void addShader(TShader* shader) { stages[shader->stage].push_back(shader); }
     std::list<TShader*>& getShaders(EShLanguage stage) { return stages[stage]; }
+
+    // Incremental linking, e.g. for reloading an edited shader: call before
+    // the first link() so that the program keeps what linking each stage on its
+    // own produced.  Then, after replaceShader(), link() only links the stages
+    // whose shader was replaced, and redoes the checks across stages; mapIO()
+    // and buildReflection() can be called again after it.  Without a resolver
+    // or mapper, mapIO() reuses the mapping of a stage the checks across stages
+    // left as before.
+    void setIncrementalLink(bool incremental) { incrementalLink = incremental; }
+
+    // Replaces oldShader, the only shader of its stage, by newShader, a shader
+    // of the same stage, typically a new parse of edited source.  After a link
+    // (which must then have been incremental), the program cannot be used until
+    // it is linked again; oldShader can be destructed before that.  Returns
+    // false, changing nothing, if the shader cannot be replaced.
+    GLSLANG_EXPORT bool replaceShader(TShader* oldShader, TShader* newShader);
+
     // Link Validation interface
     GLSLANG_EXPORT bool link(EShMessages);
     GLSLANG_EXPORT const char* getInfoLog();
@@ -988,17 +1174,33 @@ public:
     // and respects auto assignment and offsets.
     GLSLANG_EXPORT bool mapIO(TIoMapResolver* pResolver = nullptr, TIoMapper* pIoMapper = nullptr);
 
+    // Resource layout: call before mapIO() to have it fill in the program's
+    // resource layout once the bindings and locations are final.
+    void setCaptureResourceLayout(bool capture) { captureResourceLayout = capture; }
+    const TResourceLayout& getResourceLayout() const { return resourceLayout; }
+
 protected:
     GLSLANG_EXPORT bool linkStage(EShLanguage, EShMessages);
     GLSLANG_EXPORT bool crossStageCheck(EShMessages);
 
+    // For incremental linking: what a stage was like after linkStage(), before
+    // the checks across stages and the I/O mapping changed it.
+    struct TStageState;
+    void saveStageState(EShLanguage, bool stageLinked, const std::string& log);
+    bool restoreStageState(EShLanguage);
+    bool mapStageAsBefore(const TStageState&);
+
     TPoolAllocator* pool;
     std::list<TShader*> stages[EShLangCount];
     TIntermediate* intermediate[EShLangCount];
     bool newedIntermediate[EShLangCount];      // track which intermediate were "new" versus reusing a singleton unit in a stage
+    TStageState* stageState[EShLangCount];     // for incremental linking; null for a stage that needs linkStage()
     TInfoSink* infoSink;
     TReflection* reflection;
+    TResourceLayout resourceLayout;
     bool linked;
+    bool incrementalLink;
+    bool captureResourceLayout;
 
 private:
     TProgram(TProgram&);
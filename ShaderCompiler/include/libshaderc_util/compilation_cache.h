@@ -0,0 +1,191 @@
+// Copyright 2026 The Shaderc Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSHADERC_UTIL_INC_COMPILATION_CACHE_H
+#define LIBSHADERC_UTIL_INC_COMPILATION_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "counting_includer.h"
+#include "string_piece.h"
+
+namespace shaderc_util {
+
+// Accumulates bytes into a SHA-256 content digest.  A cache hit is trusted
+// without comparing the sources, so the digest has to be collision resistant.
+class CacheKeyHasher {
+ public:
+  CacheKeyHasher();
+
+  // Adds raw bytes to the digest.
+  void Add(const void* data, size_t size);
+
+  // Adds a length-prefixed string, so that adjacent strings can not alias.
+  void Add(const string_piece& str) {
+    AddValue(static_cast<uint64_t>(str.size()));
+    Add(str.data(), str.size());
+  }
+  void Add(const std::string& str) { Add(string_piece(str)); }
+  void Add(const char* str) { Add(string_piece(str ? str : "")); }
+
+  // Adds the object representation of a trivially copyable value.
+  template <typename T>
+  void AddValue(const T& value) {
+    Add(&value, sizeof(value));
+  }
+
+  // Returns the digest as a 64 character lower-case hexadecimal string.
+  std::string Digest() const;
+
+ private:
+  // Processes the 64 byte block in block_.
+  void ProcessBlock();
+
+  uint32_t state_[8];
+  unsigned char block_[64];
+  size_t block_size_;    // bytes in block_
+  uint64_t total_size_;  // bytes added so far
+};
+
+// A content-addressed store of compilation outputs.  Entries are keyed by a
+// digest of everything that can affect compilation except the contents of
+// #included files.  Each entry additionally records the include requests that
+// were made while producing it together with a digest of what they resolved
+// to, so a lookup can replay those requests and verify the dependencies are
+// unchanged without invoking glslang.
+//
+// Entries are kept in memory, up to a budget of bytes beyond which the least
+// recently used ones are dropped, and, when a directory is given, are also
+// written to and read from disk so they survive across processes.
+//
+// All methods are safe to call concurrently.
+class CompilationCache {
+ public:
+  // One include request made while compiling a cached entry.
+  struct Dependency {
+    std::string requested_source;
+    std::string requesting_source;
+    CountingIncluder::IncludeType type = CountingIncluder::IncludeType::Local;
+    uint64_t include_depth = 0;
+    // Digest of the resolved name and the contents of the included source.
+    std::string digest;
+  };
+
+  // The stored result of a successful compilation.
+  struct Entry {
+    std::vector<Dependency> dependencies;
+    std::vector<uint32_t> output_data;
+    uint64_t output_data_size_in_bytes = 0;
+    // Warnings emitted by the original compilation, replayed on a hit.
+    std::string messages;
+    uint64_t num_warnings = 0;
+  };
+
+  // The default for the bytes of entries kept in memory.
+  static const size_t kDefaultMemoryBudget = 64 * 1024 * 1024;
+
+  // Creates a cache.  If directory is empty the cache is in-memory only.
+  // Otherwise entries are also persisted as files in that directory, which
+  // must already exist.  At most about memory_budget bytes of entries are
+  // kept in memory.
+  explicit CompilationCache(const std::string& directory = "",
+                            size_t memory_budget = kDefaultMemoryBudget)
+      : directory_(directory), memory_budget_(memory_budget) {}
+
+  // Looks up the entry for key.  The recorded dependencies are resolved again
+  // through the given includer and compared against their stored digests.
+  // Returns true and fills *entry if an up-to-date entry exists.
+  bool Lookup(const std::string& key, CountingIncluder& includer,
+              Entry* entry);
+
+  // Stores entry under key, replacing any previous entry.
+  void Insert(const std::string& key, const Entry& entry);
+
+  // Drops all in-memory entries.  Files on disk are left untouched.
+  void Clear();
+
+  const std::string& directory() const { return directory_; }
+
+ private:
+  // Returns the file that holds the entry for key.
+  std::string GetEntryPath(const std::string& key) const;
+
+  // Reads and decodes the entry for key from disk.  Returns false if there is
+  // no such file or its contents are not a valid entry.
+  bool ReadEntry(const std::string& key, Entry* entry) const;
+
+  // Encodes entry and writes it to disk.  Failures are silently ignored since
+  // the cache is only an accelerator.
+  void WriteEntry(const std::string& key, const Entry& entry) const;
+
+  // Keeps entry in memory as the most recently used, dropping the least
+  // recently used entries beyond the budget.  mutex_ must be held.
+  void KeepInMemory(const std::string& key, const Entry& entry);
+
+  // An entry kept in memory.
+  struct MemoryEntry {
+    Entry entry;
+    size_t size;  // counted against the budget
+    std::list<std::string>::iterator lru_position;
+  };
+
+  const std::string directory_;
+  const size_t memory_budget_;
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, MemoryEntry> entries_;
+  // The keys of entries_, the most recently used first.
+  std::list<std::string> lru_;
+  size_t memory_size_ = 0;  // of all of entries_
+};
+
+// An includer that forwards to another includer and records every include
+// request, with a digest of the result, as a cache dependency.
+class DependencyRecordingIncluder : public CountingIncluder {
+ public:
+  explicit DependencyRecordingIncluder(CountingIncluder& includer)
+      : includer_(includer) {}
+
+  // Returns the dependencies in the order they were requested.
+  const std::vector<CompilationCache::Dependency>& dependencies() const {
+    return dependencies_;
+  }
+
+ private:
+  glslang::TShader::Includer::IncludeResult* include_delegate(
+      const char* requested_source, const char* requesting_source,
+      IncludeType type, size_t include_depth) override;
+
+  void release_delegate(
+      glslang::TShader::Includer::IncludeResult* result) override {
+    includer_.releaseInclude(result);
+  }
+
+  CountingIncluder& includer_;
+  std::vector<CompilationCache::Dependency> dependencies_;
+};
+
+// Returns the digest of an include result, covering both the resolved name and
+// the contents.  A null result digests to the same value as a failed include.
+std::string GetIncludeResultDigest(
+    const glslang::TShader::Includer::IncludeResult* result);
+
+}  // namespace shaderc_util
+
+#endif  // LIBSHADERC_UTIL_INC_COMPILATION_CACHE_H
@@ -16,16 +16,22 @@
 #define LIBSHADERC_UTIL_INC_COMPILER_H
 
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <mutex>
 #include <ostream>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "compilation_cache.h"
 #include "counting_includer.h"
 #include "file_finder.h"
+#include "glslang/Include/PoolAlloc.h"
 #include "glslang/Public/ShaderLang.h"
 #include "mutex.h"
 #include "resources.h"
@@ -40,21 +46,37 @@ namespace shaderc_util {
 // spirv_tools_wrapper.h, so cannot include spirv_tools_wrapper.h here.
 enum class PassId;
 
+class ThreadPool;
+struct GlslangClientInfo;
+
 // Initializes glslang on creation, and destroys it on completion.
 // Used to tie gslang process operations to object lifetimes.
 // Additionally initialization/finalization of glslang is not thread safe, so
 // synchronizes these operations.
+//
+// Only the first initializer and the last one to go away take a lock; any
+// others just adjust an atomic reference count.  Once
+// KeepInitializedForProcessLifetime() has been called, creating and
+// destroying initializers does not write to any shared state at all.
 class GlslangInitializer {
  public:
   GlslangInitializer();
   ~GlslangInitializer();
 
- private:
-  static unsigned int initialize_count_;
+  // Initializes glslang if needed and keeps it initialized until the process
+  // exits, no matter how many initializers come and go afterwards.  May be
+  // called any number of times from any thread.
+  static void KeepInitializedForProcessLifetime();
 
-  // Using a bare pointer here to avoid any global class construction at the
-  // beginning of the execution.
-  static std::mutex* glslang_mutex_;
+ private:
+  // Returns the mutex serializing glslang::InitializeProcess and
+  // glslang::FinalizeProcess.  It is allocated on first use and never freed,
+  // since a thread may still be waiting on it after the last initializer is
+  // destroyed.
+  static std::mutex& GetMutex();
+
+  static std::atomic<unsigned int> initialize_count_;
+  static std::atomic<bool> keep_initialized_;
 };
 
 // Maps macro names to their definitions.  Stores string_pieces, so the
@@ -196,6 +218,7 @@ class Compiler {
         suppress_warnings_(false),
         generate_debug_info_(false),
         enabled_opt_passes_(),
+        pool_allocator_options_(),
         target_env_(TargetEnv::Vulkan),
         target_env_version_(TargetEnvVersion::Default),
         target_spirv_version_(SpirvVersion::v1_0),
@@ -224,6 +247,21 @@ class Compiler {
   // effect if multiple calls of this method exist.
   void SetOptimizationLevel(OptimizationLevel level);
 
+  // Sets how glslang's pool allocator gets memory for the shaders and
+  // programs of each compilation.  Pages recycled by one compilation are
+  // reused by the next compilation on the same thread.
+  void SetPoolAllocatorOptions(const glslang::TPoolAllocatorOptions& options) {
+    pool_allocator_options_ = options;
+  }
+
+  // Sets whether each thread keeps the memory of glslang's pool allocator
+  // from one compilation to the next, without limit, instead of returning it
+  // to the system.  Overrides the recycling limit of SetPoolAllocatorOptions().
+  void SetReuseThreadArenas(bool enable) {
+    pool_allocator_options_.recycleBytes =
+        enable ? std::numeric_limits<size_t>::max() : 0;
+  }
+
   // Enables or disables HLSL legalization passes.
   void EnableHlslLegalization(bool hlsl_legalization_enabled);
 
@@ -353,6 +391,37 @@ class Compiler {
     hlsl_explicit_bindings_[static_cast<int>(stage)].push_back(binding);
   }
 
+  // Sets the cache consulted before, and populated after, each compilation.
+  // A null cache disables caching.  Copies of this Compiler share the cache.
+  //
+  // Only compilations with a forced shader stage that produce SPIR-V binary
+  // or assembly are cached.  Preprocessing output depends on the state of the
+  // caller's includer, and stages deduced through the stage callback are not
+  // captured by the cache key.
+  void SetCache(std::shared_ptr<CompilationCache> cache) {
+    cache_ = std::move(cache);
+  }
+
+  // Sets the precompiled preamble whose macros every compilation starts with.
+  // A null preamble disables it.  Copies of this Compiler share the preamble.
+  //
+  // Compilations with a precompiled preamble bypass the cache: the files its
+  // header set includes are read once, by whichever compilation first needs
+  // them, so they are not dependencies of the others.
+  void SetPrecompiledPreamble(
+      std::shared_ptr<glslang::TPrecompiledPreamble> precompiled_preamble) {
+    precompiled_preamble_ = std::move(precompiled_preamble);
+  }
+
+  // The wall time of one phase of a compilation, and the number of bytes it
+  // allocated from glslang's pool allocator.
+  struct PhaseTiming {
+    std::string name;
+    double wall_seconds;
+    // Zero for phases that run outside glslang, which allocate from the heap.
+    size_t pool_bytes;
+  };
+
   // Compiles the shader source in the input_source_string parameter.
   //
   // If the forced_shader stage parameter is not EShLangCount then
@@ -386,6 +455,21 @@ class Compiler {
   // mode; 3) the size of the output data in bytes. When the output is SPIR-V
   // binary code, the size is the number of bytes of valid data in the vector.
   // If the output is a text string, the size equals the length of that string.
+  //
+  // If a cache has been set, an up-to-date cached result is returned without
+  // invoking glslang, and successful results are added to the cache.
+  //
+  // If phase_timings is not null, an entry is appended to it for each phase
+  // the compilation goes through, in order: "preprocess" (only when it runs
+  // apart from parsing), "parse" (which includes preprocessing otherwise),
+  // "link", "map-io", "generate-spirv", "optimize", and "disassemble".  The
+  // steps of "optimize" follow it as "optimize/<pass name>".  A cache hit
+  // records a single "cache-lookup".
+  //
+  // If resource_layout is not null, it is set to the layout of the shader's
+  // resources and inputs and outputs once they are mapped, see
+  // glslang::TResourceLayout.  The cache is then not used, since its entries
+  // do not keep layouts.
   std::tuple<bool, std::vector<uint32_t>, size_t> Compile(
       const string_piece& input_source_string, EShLanguage forced_shader_stage,
       const std::string& error_tag, const char* entry_point_name,
@@ -394,14 +478,131 @@ class Compiler {
           stage_callback,
       CountingIncluder& includer, OutputType output_type,
       std::ostream* error_stream, size_t* total_warnings,
+      size_t* total_errors,
+      std::vector<PhaseTiming>* phase_timings = nullptr,
+      glslang::TResourceLayout* resource_layout = nullptr) const;
+
+  // Preprocesses input_source_string as Compile() does for
+  // OutputType::PreprocessedText, but instead of returning the text, passes it
+  // to text_sink in order, a piece at a time, as it is produced.  The preamble
+  // is removed on the way, so only about a piece of output is held at once.
+  //
+  // Compile() adds an #extension line and a #line directive for the main file
+  // to the text if a #include took effect, as counted by includer.  Here the
+  // text after the preamble is held back until the first #include takes
+  // effect or preprocessing ends, unless the source text cannot #include.  At
+  // most 256 KiB is held: beyond that the lines are added as if a file was
+  // included, even if none is.
+  //
+  // Text is passed on before it is known whether preprocessing succeeds; it
+  // should be discarded if this returns false.  Errors and counts are reported
+  // as by Compile().  The cache is not used.
+  bool PreprocessToSink(
+      const string_piece& input_source_string, const std::string& error_tag,
+      CountingIncluder& includer,
+      const std::function<void(const string_piece& text)>& text_sink,
+      std::ostream* error_stream, size_t* total_warnings,
       size_t* total_errors) const;
 
+  // Finds the files input_source_string includes and the macros its
+  // conditional directives test, for use in build dependencies.  Only the
+  // preprocessor directives outside skipped conditional blocks are run, with
+  // the predefined macros in effect, so this is much cheaper than
+  // preprocessing.  Includes are resolved with includer and recorded by the
+  // names it gives them.  Returns false if there were errors, which are
+  // reported as by Compile(); dependencies may then be incomplete.
+  bool ScanDependencies(const string_piece& input_source_string,
+                        const std::string& error_tag,
+                        CountingIncluder& includer,
+                        glslang::TShader::Dependencies* dependencies,
+                        std::ostream* error_stream, size_t* total_warnings,
+                        size_t* total_errors) const;
+
+  // One stage of a pipeline compiled by CompilePipeline().  The fields have
+  // the meaning of the Compile() parameters of the same names; the stage is
+  // always forced.  includer is used by this stage only.
+  struct PipelineStage {
+    string_piece source;
+    EShLanguage stage;
+    std::string error_tag;
+    const char* entry_point_name;
+    CountingIncluder* includer;
+  };
+
+  // What CompilePipeline() produced for one stage.
+  struct PipelineStageResult {
+    bool succeeded = false;
+    // The SPIR-V binary module, if the whole pipeline compiled.
+    std::vector<uint32_t> spirv;
+    // The messages of parsing this stage, then those of linking the pipeline.
+    std::string messages;
+    size_t num_warnings = 0;
+    size_t num_errors = 0;
+  };
+
+  // Compiles the stages of one pipeline, such as a vertex and a fragment
+  // shader, into a SPIR-V binary module per stage, and writes one result per
+  // stage to *results, in the order of stages.  No two stages may be the same.
+  //
+  // Each stage is parsed as Compile() parses a shader of a forced stage, as a
+  // task on thread_pool, or in turn if it is null.  The parsed stages are then
+  // linked as one glslang program, on the calling thread, which checks the
+  // interfaces between them and maps their inputs and outputs together.
+  //
+  // If an optimization level is set, the stages are optimized from the last
+  // one back, and each stage of vertex processing drops its stores to outputs
+  // the next stage never reads (unless it captures them for transform
+  // feedback), before the dead code left behind is removed.
+  //
+  // If resource_layout is not null, it is set to the layout of the resources
+  // and inputs and outputs of the whole pipeline, as for Compile().
+  //
+  // Returns true only if every stage compiled.  Otherwise no stage has a
+  // module.  The cache is not used, and only binary output is produced.
+  bool CompilePipeline(
+      const std::vector<PipelineStage>& stages, ThreadPool* thread_pool,
+      std::vector<PipelineStageResult>* results,
+      glslang::TResourceLayout* resource_layout = nullptr) const;
+
   static EShMessages GetDefaultRules() {
     return static_cast<EShMessages>(EShMsgSpvRules | EShMsgVulkanRules |
                                     EShMsgCascadingErrors);
   }
 
  protected:
+  // Sets every property of shader that follows from the options on this
+  // Compiler, for parsing a shader of the given stage.
+  void ConfigureShader(glslang::TShader* shader, EShLanguage stage,
+                       const char* entry_point_name,
+                       const GlslangClientInfo& target_client_info) const;
+
+  // Returns the optimizer passes to run on generated SPIR-V: legalization for
+  // HLSL, if enabled, then the passes of the optimization level.
+  std::vector<PassId> GetOptimizationPasses() const;
+
+  // Like Compile(), but always compiles the shader and never consults or
+  // updates the cache.
+  std::tuple<bool, std::vector<uint32_t>, size_t> CompileUncached(
+      const string_piece& input_source_string, EShLanguage forced_shader_stage,
+      const std::string& error_tag, const char* entry_point_name,
+      const std::function<EShLanguage(std::ostream* error_stream,
+                                      const string_piece& error_tag)>&
+          stage_callback,
+      CountingIncluder& includer, OutputType output_type,
+      std::ostream* error_stream, size_t* total_warnings,
+      size_t* total_errors, std::vector<PhaseTiming>* phase_timings,
+      glslang::TResourceLayout* resource_layout) const;
+
+  // Returns the cache key for compiling input_source_string with the given
+  // arguments.  The key covers the source, the predefined macros, every
+  // option on this Compiler, and the versions of glslang and SPIRV-Tools.
+  // It does not cover #included files; those are tracked by the cache entry.
+  std::string GetCacheKey(const string_piece& input_source_string,
+                          EShLanguage forced_shader_stage,
+                          const std::string& error_tag,
+                          const char* entry_point_name,
+                          OutputType output_type) const;
+
   // Preprocesses a shader whose filename is filename and content is
   // shader_source. If preprocessing is successful, returns true, the
   // preprocessed shader, and any warning message as a tuple. Otherwise,
@@ -418,9 +619,20 @@ class Compiler {
   // If force_version_profile_ is set, the shader's version/profile is forced
   // to be default_version_/default_profile_ regardless of the #version
   // directive in the source code.
+  //
+  // If output_sink is not null, the preprocessed shader is written to it as it
+  // is produced, and the returned string is empty.  If dependencies is not
+  // null, only the directives are run, filling it in as described for
+  // ScanDependencies(), and the returned string is empty too.
+  //
+  // If text_is_exact is not null, it is set to whether parsing the
+  // preprocessed shader would see the same tokens as parsing the source.
   std::tuple<bool, std::string, std::string> PreprocessShader(
       const std::string& error_tag, const string_piece& shader_source,
-      const string_piece& shader_preamble, CountingIncluder& includer) const;
+      const string_piece& shader_preamble, CountingIncluder& includer,
+      glslang::TShader::PreprocessedTextSink* output_sink = nullptr,
+      glslang::TShader::Dependencies* dependencies = nullptr,
+      bool* text_is_exact = nullptr) const;
 
   // Cleans up the preamble in a given preprocessed shader.
   //
@@ -452,9 +664,11 @@ class Compiler {
   // possible. In the returned pair, the glslang EShLanguage is the shader
   // stage deduced. If no #pragma directives for shader stage exist, it's
   // EShLangCount.  If errors occur, the second element in the pair is the
-  // error message.  Otherwise, it's an empty string.
+  // error message.  Otherwise, it's an empty string.  is_for_next_line tells
+  // how #line directives count lines for the shader's version and profile.
   std::pair<EShLanguage, std::string> GetShaderStageFromSourceCode(
-      string_piece filename, const std::string& preprocessed_shader) const;
+      string_piece filename, const std::string& preprocessed_shader,
+      bool is_for_next_line) const;
 
   // Determines version and profile from command line, or the source code.
   // Returns the decoded version and profile pair on success. Otherwise,
@@ -490,6 +704,9 @@ class Compiler {
   // Optimization passes to be applied.
   std::vector<PassId> enabled_opt_passes_;
 
+  // How glslang's pool allocator gets memory during compilation.
+  glslang::TPoolAllocatorOptions pool_allocator_options_;
+
   // The target environment to compile with. This controls the glslang
   // EshMessages bitmask, which determines which dialect of GLSL and which
   // SPIR-V codegen semantics are used. This impacts the warning & error
@@ -569,6 +786,12 @@ class Compiler {
   // name, and the set and binding numbers it should be mapped to, but in
   // the form of strings.  This is how Glslang wants to consume the data.
   std::vector<std::string> hlsl_explicit_bindings_[kNumStages];
+
+  // The compilation cache, or null if caching is disabled.
+  std::shared_ptr<CompilationCache> cache_;
+
+  // The header set whose macros each compilation starts with, or null.
+  std::shared_ptr<glslang::TPrecompiledPreamble> precompiled_preamble_;
 };
 
 // Converts a string to a vector of uint32_t by copying the content of a given
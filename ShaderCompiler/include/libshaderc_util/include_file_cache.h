@@ -0,0 +1,88 @@
+// Copyright 2026 The Shaderc Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSHADERC_UTIL_INC_INCLUDE_FILE_CACHE_H
+#define LIBSHADERC_UTIL_INC_INCLUDE_FILE_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "counting_includer.h"
+#include "file_finder.h"
+
+namespace shaderc_util {
+
+// The contents of #included files, shared by any number of compilations.
+// Files are keyed by their resolved path and revalidated against their size
+// and modification time on every lookup, so a file is read again once it has
+// been edited, but an unchanged file is read only once per cache.
+//
+// All methods are safe to call concurrently.
+class IncludeFileCache {
+ public:
+  // The contents of one file.  Compilations hold on to them through this
+  // pointer, so they stay valid even if the cache replaces them meanwhile.
+  using Contents = std::shared_ptr<const std::string>;
+
+  // Returns the contents of the file at path, reading the file unless it is
+  // cached and unchanged.  Returns null if the file can not be read.
+  Contents Read(const std::string& path);
+
+  // Drops all cached contents.
+  void Clear();
+
+ private:
+  // The cached state of one file.  Each has its own mutex so that different
+  // files can be read concurrently, while concurrent requests for the same
+  // file wait for a single read.
+  struct Slot {
+    std::mutex mutex;
+    Contents contents;
+    std::filesystem::file_time_type mtime;
+    uintmax_t size = 0;
+  };
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<Slot>> slots_;
+};
+
+// An includer that resolves #include directives against the file system,
+// reading files through an IncludeFileCache.  "" includes are first looked
+// for relative to the including file, then in the search path of the given
+// FileFinder; <> includes only in the search path.
+class CachingFileIncluder : public CountingIncluder {
+ public:
+  CachingFileIncluder(std::shared_ptr<IncludeFileCache> cache,
+                      const FileFinder& file_finder)
+      : cache_(std::move(cache)), file_finder_(file_finder) {}
+
+ private:
+  glslang::TShader::Includer::IncludeResult* include_delegate(
+      const char* requested_source, const char* requesting_source,
+      IncludeType type, size_t include_depth) override;
+
+  void release_delegate(
+      glslang::TShader::Includer::IncludeResult* result) override;
+
+  std::shared_ptr<IncludeFileCache> cache_;
+  const FileFinder& file_finder_;
+};
+
+}  // namespace shaderc_util
+
+#endif  // LIBSHADERC_UTIL_INC_INCLUDE_FILE_CACHE_H
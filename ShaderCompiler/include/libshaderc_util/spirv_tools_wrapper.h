@@ -15,7 +15,10 @@
 #ifndef LIBSHADERC_UTIL_INC_SPIRV_TOOLS_WRAPPER_H
 #define LIBSHADERC_UTIL_INC_SPIRV_TOOLS_WRAPPER_H
 
+#include <cstdint>
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "spirv-tools/libspirv.hpp"
@@ -51,17 +54,41 @@ enum class PassId {
   kNullPass,
   kStripDebugInfo,
   kCompactIds,
+
+  // Passes across the interface between two stages of a pipeline, which
+  // need a StageInterface
+  kEliminateDeadOutputStores,
+  kAnalyzeLiveInputs,
+};
+
+// The interface between a shader and the next stage of its pipeline.
+struct StageInterface {
+  // The input locations and built-ins the next stage reads.
+  // kEliminateDeadOutputStores removes the stores to other outputs, and the
+  // code left dead by that.
+  std::unordered_set<uint32_t> next_stage_live_locations;
+  std::unordered_set<uint32_t> next_stage_live_builtins;
+  // kAnalyzeLiveInputs adds the input locations and built-ins this shader
+  // reads, for the stage before it.
+  std::unordered_set<uint32_t> live_input_locations;
+  std::unordered_set<uint32_t> live_input_builtins;
 };
 
 // Optimizes the given binary. Passes are registered in the exact order as shown
-// in enabled_passes, without de-duplication. Returns true and writes the
-// optimized binary back to *binary if successful. Otherwise, writes errors to
-// *errors and the content of binary may be in an invalid state.
-bool SpirvToolsOptimize(Compiler::TargetEnv env,
-                        Compiler::TargetEnvVersion version,
-                        const std::vector<PassId>& enabled_passes,
-                        spvtools::OptimizerOptions& optimizer_options,
-                        std::vector<uint32_t>* binary, std::string* errors);
+// in enabled_passes, without de-duplication.
+// If pass_timings is not null, the name and wall time of each optimizer step
+// are appended to it.  stage_interface must not be null if enabled_passes
+// includes a pass across stages.
+// Returns true and writes the optimized binary back to *binary if successful.
+// Otherwise, writes errors to *errors and the content of binary may be in an
+// invalid state.
+bool SpirvToolsOptimize(
+    Compiler::TargetEnv env, Compiler::TargetEnvVersion version,
+    const std::vector<PassId>& enabled_passes,
+    spvtools::OptimizerOptions& optimizer_options,
+    std::vector<uint32_t>* binary, std::string* errors,
+    std::vector<std::pair<std::string, double>>* pass_timings = nullptr,
+    StageInterface* stage_interface = nullptr);
 
 }  // namespace shaderc_util
 
@@ -0,0 +1,88 @@
+// Copyright 2026 The Shaderc Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSHADERC_UTIL_INC_THREAD_POOL_H
+#define LIBSHADERC_UTIL_INC_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace shaderc_util {
+
+// A fixed-size pool of worker threads with one task queue per worker.  Idle
+// workers steal from the other queues, so a batch of unevenly sized tasks
+// still keeps every worker busy until the batch is drained.
+//
+// Worker threads live as long as the pool, so any thread-local state built up
+// while running a task (for example glslang's per-thread allocators and symbol
+// table bookkeeping) is reused by later tasks on the same worker.
+class ThreadPool {
+ public:
+  // Creates a pool with num_threads workers.  Zero means one worker per
+  // hardware thread.
+  explicit ThreadPool(size_t num_threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Returns the number of worker threads.
+  size_t num_threads() const { return workers_.size(); }
+
+  // Calls task(i) for every i in [0, count) and returns once all calls have
+  // completed.  Calls run concurrently on the workers; the calling thread
+  // also runs tasks while it waits.  May be called from several threads at
+  // once, but must not be called from inside a task.
+  void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+ private:
+  using Task = std::function<void()>;
+
+  // A worker's own task queue.  The owner pops from the back, thieves take
+  // from the front, so they contend only when the queue is nearly empty.
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  // Pops a task from queue index's own end.
+  bool PopLocal(size_t index, Task* task);
+
+  // Takes a task from the front of any queue, starting after index.
+  bool Steal(size_t index, Task* task);
+
+  // The main loop of the worker owning queue index.
+  void WorkerLoop(size_t index);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+
+  // Guards sleeping and waking of idle workers.
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  // The number of tasks pushed but not yet taken by anyone.
+  std::atomic<size_t> pending_;
+  bool stopping_;
+};
+
+}  // namespace shaderc_util
+
+#endif  // LIBSHADERC_UTIL_INC_THREAD_POOL_H
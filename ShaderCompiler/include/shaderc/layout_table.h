@@ -0,0 +1,146 @@
+// Copyright 2026 The Shaderc Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SHADERC_LAYOUT_TABLE_H_
+#define SHADERC_LAYOUT_TABLE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A layout table describes the descriptors, push constants, and user-defined
+// inputs and outputs of a shader or pipeline, with the layout of each block.
+// It is produced by shaderc_result_get_layout_table(), and is meant to be
+// stored and later read in place, e.g. from a memory-mapped file, without
+// depending on the rest of libshaderc.
+//
+// A table is a sequence of 32-bit words in the byte order of the machine that
+// produced it, so its size is a multiple of 4.  It is laid out as:
+//   shaderc_layout_table_header
+//   num_resources shaderc_layout_resource records
+//   num_members shaderc_layout_member records
+//   names_size bytes of names, each ending with a NUL, padded with NULs
+// A reader should check the magic number, which also reveals a table of the
+// other byte order, and the version before reading anything else.
+//
+// Fields that do not apply to a record are SHADERC_LAYOUT_NONE, unless their
+// comment says otherwise.
+
+#define SHADERC_LAYOUT_TABLE_MAGIC 0x544c4353u  // "SCLT" in little endian
+#define SHADERC_LAYOUT_TABLE_VERSION 1u
+#define SHADERC_LAYOUT_NONE 0xffffffffu
+
+typedef struct {
+  uint32_t magic;    // SHADERC_LAYOUT_TABLE_MAGIC
+  uint32_t version;  // SHADERC_LAYOUT_TABLE_VERSION
+  uint32_t size;     // of the whole table, in bytes
+  uint32_t num_resources;
+  uint32_t num_members;
+  uint32_t names_size;
+} shaderc_layout_table_header;
+
+// What a resource record describes.  The kinds up to and including
+// shaderc_layout_kind_acceleration_structure are bound through descriptor
+// sets.
+typedef enum {
+  shaderc_layout_kind_uniform_buffer = 0,
+  shaderc_layout_kind_storage_buffer = 1,
+  shaderc_layout_kind_sampler = 2,
+  shaderc_layout_kind_sampled_image = 3,
+  shaderc_layout_kind_combined_image_sampler = 4,
+  shaderc_layout_kind_storage_image = 5,
+  shaderc_layout_kind_uniform_texel_buffer = 6,
+  shaderc_layout_kind_storage_texel_buffer = 7,
+  shaderc_layout_kind_input_attachment = 8,
+  shaderc_layout_kind_acceleration_structure = 9,
+  shaderc_layout_kind_push_constant = 10,
+  // A uniform outside of a block, as in OpenGL.
+  shaderc_layout_kind_uniform = 11,
+  shaderc_layout_kind_input = 12,
+  shaderc_layout_kind_output = 13,
+} shaderc_layout_kind;
+
+// The type of the components of a scalar, vector, or matrix.
+typedef enum {
+  shaderc_layout_numeric_none = 0,  // a block, struct, or opaque type
+  shaderc_layout_numeric_float = 1,
+  shaderc_layout_numeric_int = 2,
+  shaderc_layout_numeric_uint = 3,
+  shaderc_layout_numeric_bool = 4,
+} shaderc_layout_numeric;
+
+#define SHADERC_LAYOUT_MEMBER_ROW_MAJOR 0x1u
+
+// A descriptor, push constant block, loose uniform, input, or output.
+// Resources declared by several stages are listed once; inputs and outputs
+// are listed for each stage.
+typedef struct {
+  uint32_t name;  // byte offset of the name in the names; for a block, the
+                  // name of the block rather than of its instance
+  uint32_t kind;  // a shaderc_layout_kind
+  // The matching VkDescriptorType value for a descriptor.
+  uint32_t descriptor_type;
+  uint32_t stages;  // VkShaderStageFlagBits of the stages that declare it
+  uint32_t set;
+  uint32_t binding;
+  // Of an input, output, or loose uniform, or the input attachment index of
+  // an input attachment.
+  uint32_t location;
+  uint32_t component;
+  // The number of elements of all array dimensions: 1 if not an array, 0 if
+  // sized at run time.
+  uint32_t array_size;
+  uint32_t size;  // of the data of a block, in bytes
+  // The type of anything other than a block, as for a member.
+  uint32_t numeric;
+  uint32_t width;
+  uint32_t vector_size;
+  uint32_t matrix_columns;
+  // A block's members are num_members member records starting at index
+  // first_member.
+  uint32_t first_member;
+  uint32_t num_members;  // 0 if not a block
+} shaderc_layout_resource;
+
+// A member of a block, or a field of a member of struct type.  Offsets are
+// from the start of the block or struct, in bytes.
+typedef struct {
+  uint32_t name;  // byte offset of the name in the names
+  uint32_t offset;
+  // In bytes, of all elements of an array; of one element of an array sized
+  // at run time.
+  uint32_t size;
+  // The number of elements of the outermost array dimension: 1 if not an
+  // array, 0 if sized at run time.
+  uint32_t array_size;
+  uint32_t array_stride;   // 0 if not an array
+  uint32_t matrix_stride;  // 0 if not a matrix
+  uint32_t flags;          // SHADERC_LAYOUT_MEMBER_* bits
+  uint32_t numeric;        // a shaderc_layout_numeric
+  uint32_t width;          // in bits, of each component
+  uint32_t vector_size;    // of a vector, or of each column of a matrix
+  uint32_t matrix_columns;  // 0 if not a matrix
+  // The fields of a struct are num_members member records starting at index
+  // first_member.
+  uint32_t first_member;
+  uint32_t num_members;  // 0 if not a struct
+} shaderc_layout_member;
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif  // SHADERC_LAYOUT_TABLE_H_
@@ -272,6 +272,14 @@ SHADERC_EXPORT shaderc_compiler_t shaderc_compiler_initialize(void);
 // involving this shaderc_compiler_t.
 SHADERC_EXPORT void shaderc_compiler_release(shaderc_compiler_t);
 
+// Initializes the process-wide compiler state, if needed, and keeps it alive
+// until the process exits instead of tearing it down whenever the last
+// shaderc_compiler_t is released.  Afterwards shaderc_compiler_initialize and
+// shaderc_compiler_release no longer synchronize with each other, which makes
+// short-lived compilers cheap to create from many threads at once.  May be
+// safely called from multiple threads without explicit synchronization.
+SHADERC_EXPORT void shaderc_compiler_keep_process_initialized(void);
+
 // An opaque handle to an object that manages options to a single compilation
 // result.
 typedef struct shaderc_compile_options* shaderc_compile_options_t;
@@ -324,6 +332,41 @@ SHADERC_EXPORT void shaderc_compile_options_set_generate_debug_info(
 SHADERC_EXPORT void shaderc_compile_options_set_optimization_level(
     shaderc_compile_options_t options, shaderc_optimization_level level);
 
+// Sets how the front end's pool allocator, which holds the syntax tree and
+// symbol tables of a compilation, gets memory.  It takes page_size bytes at a
+// time from the system; the default is 8 KB, and large shaders benefit from
+// 64 KB or more.  With huge_pages, pages are backed by 2 MB transparent huge
+// pages where the system supports them, and page_size is rounded up to a
+// multiple of 2 MB.  When recycle_bytes is nonzero, each thread keeps up to
+// that many bytes of pages when a compilation finishes, for its next
+// compilation with the same page size and huge_pages setting, instead of
+// returning them to the system.
+SHADERC_EXPORT void shaderc_compile_options_set_pool_allocator(
+    shaderc_compile_options_t options, size_t page_size, bool huge_pages,
+    size_t recycle_bytes);
+
+// Sets whether each thread that compiles with these options keeps all the
+// memory of the front end's pool allocator from one compilation to the next,
+// instead of returning it to the system.  This suits long-lived services and
+// batch workers: once a thread has run its largest compilation, later ones
+// with the same pool allocator settings take no pool memory from the system.
+// The memory is released when the thread exits.  Enabling this is the same as
+// a recycle_bytes of SIZE_MAX in shaderc_compile_options_set_pool_allocator(),
+// and disabling it the same as a recycle_bytes of 0.  Disabled by default.
+SHADERC_EXPORT void shaderc_compile_options_set_reuse_thread_arenas(
+    shaderc_compile_options_t options, bool enable);
+
+// Sets whether compilations with these options record how long each phase
+// takes, for shaderc_result_get_phase_timings().  Disabled by default.
+SHADERC_EXPORT void shaderc_compile_options_set_collect_phase_timings(
+    shaderc_compile_options_t options, bool enable);
+
+// Sets whether compilations into SPIR-V binary or assembly with these options
+// produce a layout table, for shaderc_result_get_layout_table().  Such
+// compilations bypass the compilation cache.  Disabled by default.
+SHADERC_EXPORT void shaderc_compile_options_set_generate_layout_table(
+    shaderc_compile_options_t options, bool enable);
+
 // Forces the GLSL language version and profile to a given pair. The version
 // number is the same as would appear in the #version annotation in the source.
 // Version and profile specified here overrides the #version annotation in the
@@ -385,6 +428,38 @@ SHADERC_EXPORT void shaderc_compile_options_set_include_callbacks(
     shaderc_compile_options_t options, shaderc_include_resolve_fn resolver,
     shaderc_include_result_release_fn result_releaser, void* user_data);
 
+// An opaque handle to a cache of #included file contents.  A cache can be
+// shared by any number of compile options, and may be used from multiple
+// threads without explicit synchronization.
+typedef struct shaderc_include_file_cache* shaderc_include_file_cache_t;
+
+// Returns a new, empty include file cache.  Files are keyed by their resolved
+// path and checked against their size and modification time whenever they are
+// included, so each unchanged file is read from disk only once, however many
+// compilations include it.  A return of NULL indicates an allocation failure.
+SHADERC_EXPORT shaderc_include_file_cache_t
+    shaderc_include_file_cache_initialize(void);
+
+// Releases the given cache handle.  Compile options the cache has been set on
+// keep using it until they are released or given another cache.  It is safe
+// to pass NULL to this function, and doing such will have no effect.
+SHADERC_EXPORT void shaderc_include_file_cache_release(
+    shaderc_include_file_cache_t cache);
+
+// Makes compilations with these options resolve #include directives from the
+// file system, reading files through the given cache, instead of through the
+// include callbacks.  #include "name" is looked for relative to the including
+// file first, then in each include directory in turn; #include <name> only
+// in the include directories.  Passing NULL goes back to the include
+// callbacks, which is the default.
+SHADERC_EXPORT void shaderc_compile_options_set_include_file_cache(
+    shaderc_compile_options_t options, shaderc_include_file_cache_t cache);
+
+// Appends a directory to the search path used when #include directives are
+// resolved from the file system.
+SHADERC_EXPORT void shaderc_compile_options_add_include_directory(
+    shaderc_compile_options_t options, const char* directory);
+
 // Sets the compiler mode to suppress warnings, overriding warnings-as-errors
 // mode. When both suppress-warnings and warnings-as-errors modes are
 // turned on, warning messages will be inhibited, and will not be emitted
@@ -506,6 +581,74 @@ SHADERC_EXPORT void shaderc_compile_options_set_invert_y(
 SHADERC_EXPORT void shaderc_compile_options_set_nan_clamp(
     shaderc_compile_options_t options, bool enable);
 
+// An opaque handle to a cache of compilation results.  A cache can be shared
+// by any number of compile options, and may be used from multiple threads
+// without explicit synchronization.
+typedef struct shaderc_compilation_cache* shaderc_compilation_cache_t;
+
+// Returns a new, empty compilation cache.  Cached results are keyed by the
+// source text, the contents of every #included source, the predefined macros
+// and all other compile options, so a hit returns exactly the output a fresh
+// compilation would produce.  Up to 64 MiB of results are kept in memory,
+// dropping the least recently used ones beyond that.  If directory is NULL or
+// empty, results are only kept in memory.  Otherwise they are also written as
+// files into directory, which must already exist, and are reused by later
+// processes pointing at the same directory.  A return of NULL indicates an
+// allocation failure.
+SHADERC_EXPORT shaderc_compilation_cache_t
+    shaderc_compilation_cache_initialize(const char* directory);
+
+// Releases the given cache handle.  Compile options the cache has been set on
+// keep using it until they are released or given another cache.  It is safe
+// to pass NULL to this function, and doing such will have no effect.
+SHADERC_EXPORT void shaderc_compilation_cache_release(
+    shaderc_compilation_cache_t cache);
+
+// Sets the cache used by compilations with these options.  Passing NULL
+// disables caching, which is the default.  Only SPIR-V binary and assembly
+// compilations with a specific (not inferred or default) shader kind are
+// cached; other compilations behave as if no cache was set.
+SHADERC_EXPORT void shaderc_compile_options_set_cache(
+    shaderc_compile_options_t options, shaderc_compilation_cache_t cache);
+
+// An opaque handle to a precompiled preamble: a header set shared by many
+// shaders, typically the permutations of one shader, which only defines
+// macros.  A precompiled preamble can be shared by any number of compile
+// options, and may be used from multiple threads without explicit
+// synchronization.
+typedef struct shaderc_precompiled_preamble* shaderc_precompiled_preamble_t;
+
+// Returns a precompiled preamble for the given header set, e.g.
+// "#include \"permutation_common.glsl\"\n".  The text may contain nothing but
+// preprocessor directives, and may not use #version, #extension or #pragma.
+// #include directives are resolved through the include callbacks of the
+// compilation that first uses the preamble, relative to name.
+//
+// Compilations using the preamble start out with the macros the header set
+// leaves defined, as if it were included before the first line of their
+// source.  The header set is preprocessed only once for each distinct
+// language version and profile, however, so it cannot see macros defined by
+// shaderc_compile_options_add_macro_definition(), and files it includes are
+// read only once.  Redefining one of its macros differently is an error.
+// A return of NULL indicates an allocation failure.
+SHADERC_EXPORT shaderc_precompiled_preamble_t
+    shaderc_precompiled_preamble_create(const char* text, size_t text_size,
+                                        const char* name);
+
+// Releases the given precompiled preamble handle.  Compile options the
+// preamble has been set on keep using it until they are released or given
+// another preamble.  It is safe to pass NULL to this function, and doing such
+// will have no effect.
+SHADERC_EXPORT void shaderc_precompiled_preamble_release(
+    shaderc_precompiled_preamble_t preamble);
+
+// Sets the precompiled preamble used by compilations with these options.
+// Passing NULL disables it, which is the default.  Compilations using a
+// precompiled preamble are not cached.
+SHADERC_EXPORT void shaderc_compile_options_set_precompiled_preamble(
+    shaderc_compile_options_t options,
+    shaderc_precompiled_preamble_t preamble);
+
 // An opaque handle to the results of a call to any shaderc_compile_into_*()
 // function.
 typedef struct shaderc_compilation_result* shaderc_compilation_result_t;
@@ -535,6 +678,23 @@ SHADERC_EXPORT shaderc_compilation_result_t shaderc_compile_into_spv(
     const char* input_file_name, const char* entry_point_name,
     const shaderc_compile_options_t additional_options);
 
+// Like shaderc_compile_into_spv, but writes the SPIR-V binary into the
+// caller-owned buffer of buffer_size bytes when it fits, so the result does
+// not need a heap copy of its own.  shaderc_result_get_length() always returns
+// the size of the binary.  If that is at most buffer_size, the binary is in
+// buffer and shaderc_result_get_bytes() returns buffer.  Otherwise nothing is
+// written to buffer and the result holds the binary, as it would for
+// shaderc_compile_into_spv; a NULL buffer with a buffer_size of zero thus
+// queries the required size without compiling twice.  The buffer must stay
+// valid for as long as the result is used, and should be 4-byte aligned if
+// the binary is read as 32-bit words.
+SHADERC_EXPORT shaderc_compilation_result_t shaderc_compile_into_spv_buffer(
+    const shaderc_compiler_t compiler, const char* source_text,
+    size_t source_text_size, shaderc_shader_kind shader_kind,
+    const char* input_file_name, const char* entry_point_name,
+    const shaderc_compile_options_t additional_options, void* buffer,
+    size_t buffer_size);
+
 // Like shaderc_compile_into_spv, but the result contains SPIR-V assembly text
 // instead of a SPIR-V binary module.  The SPIR-V assembly syntax is as defined
 // by the SPIRV-Tools open source project.
@@ -552,6 +712,121 @@ SHADERC_EXPORT shaderc_compilation_result_t shaderc_compile_into_preprocessed_te
     const char* input_file_name, const char* entry_point_name,
     const shaderc_compile_options_t additional_options);
 
+// Receives one piece of preprocessed source code.  text is not
+// null-terminated and is only valid during the call.
+typedef void (*shaderc_preprocessed_text_callback)(void* user_data,
+                                                   const char* text,
+                                                   size_t text_size);
+
+// Like shaderc_compile_into_preprocessed_text, but the preprocessed source
+// code is handed to callback in pieces as it is produced instead of being
+// collected in the result.  The result holds the status and messages and no
+// output.  If the compilation fails, the text passed to callback so far should
+// be discarded.  A NULL callback fails the compilation.
+//
+// The pieces concatenate to the text shaderc_compile_into_preprocessed_text
+// would return.  That text starts with an #extension and a #line directive
+// if, and only if, a file was included, which is only known once an #include
+// takes effect or preprocessing ends.  Until then, if the source contains
+// "include" or a backslash, the output is held back rather than passed on,
+// but at most 256 KiB of it: past that, the directives are added as if a file
+// was included, and the text then differs from what
+// shaderc_compile_into_preprocessed_text would return if none is.  Apart from
+// that, at most about 64 KiB of output is held at once.
+SHADERC_EXPORT shaderc_compilation_result_t
+shaderc_compile_into_preprocessed_text_callback(
+    const shaderc_compiler_t compiler, const char* source_text,
+    size_t source_text_size, shaderc_shader_kind shader_kind,
+    const char* input_file_name, const char* entry_point_name,
+    const shaderc_compile_options_t additional_options,
+    shaderc_preprocessed_text_callback callback, void* user_data);
+
+// Scans the given source for what its preprocessing depends on, for use by
+// build systems: the files it includes, resolved through the includer set on
+// additional_options, and the macros its conditional directives test.  Only
+// the preprocessor directives outside skipped conditional blocks are run, so
+// this is much cheaper than preprocessing.  The dependencies are read with
+// shaderc_result_get_included_files() and shaderc_result_get_tested_macros().
+//
+// If depfile_target is not NULL, the output of the result is a Makefile rule
+// making depfile_target depend on input_file_name and the included files,
+// with the characters Make treats specially escaped.  Otherwise the output is
+// empty.
+SHADERC_EXPORT shaderc_compilation_result_t shaderc_scan_dependencies(
+    const shaderc_compiler_t compiler, const char* source_text,
+    size_t source_text_size, const char* input_file_name,
+    const char* depfile_target,
+    const shaderc_compile_options_t additional_options);
+
+// One compilation in a batch passed to shaderc_compile_batch_into_spv.  The
+// fields have the same meaning as the parameters of shaderc_compile_into_spv.
+// Several jobs may share the same options object.
+typedef struct {
+  const char* source_text;
+  size_t source_text_size;
+  shaderc_shader_kind shader_kind;
+  const char* input_file_name;
+  const char* entry_point_name;
+  shaderc_compile_options_t options;
+} shaderc_compile_job;
+
+// Sets the number of worker threads used by shaderc_compile_batch_into_spv on
+// this compiler.  Zero, the default, means one worker per hardware thread.
+// The workers are started by the next batch compilation and are stopped when
+// the compiler is released or the count is changed again.
+SHADERC_EXPORT void shaderc_compiler_set_batch_thread_count(
+    shaderc_compiler_t compiler, size_t num_threads);
+
+// Compiles num_jobs shaders into SPIR-V binaries in parallel and writes one
+// result per job to results[0] through results[num_jobs - 1], in job order.
+// Each result must be released with shaderc_result_release, and is identical
+// to what shaderc_compile_into_spv would have returned for that job.
+//
+// The jobs run on a pool of worker threads owned by the compiler, which keep
+// their per-thread glslang state from one job to the next.  Include callbacks
+// set on the options may therefore be invoked concurrently from several
+// threads, and must be safe to call that way.  The calling thread also runs
+// jobs while it waits.  May be safely called from multiple threads without
+// explicit synchronization.
+SHADERC_EXPORT void shaderc_compile_batch_into_spv(
+    const shaderc_compiler_t compiler, const shaderc_compile_job* jobs,
+    size_t num_jobs, shaderc_compilation_result_t* results);
+
+// One stage of a pipeline passed to shaderc_compile_pipeline_into_spv.  The
+// fields have the same meaning as the parameters of shaderc_compile_into_spv,
+// except that shader_kind must name a specific stage.
+typedef struct {
+  const char* source_text;
+  size_t source_text_size;
+  shaderc_shader_kind shader_kind;
+  const char* input_file_name;
+  const char* entry_point_name;
+} shaderc_pipeline_stage;
+
+// Compiles the stages of one pipeline, for example a vertex and a fragment
+// shader, into SPIR-V binary modules linked as one program.  Unlike separate
+// compilations, this checks the interfaces between the stages, and locations
+// assigned by shaderc_compile_options_set_auto_map_locations match across
+// them.  With an optimization level set, a vertex processing stage also drops
+// its stores to outputs that the next stage never reads.  No two stages may
+// be the same.  The compilation cache is not used.
+//
+// The stages are parsed in parallel on the compiler's batch workers (see
+// shaderc_compiler_set_batch_thread_count), so include callbacks may be
+// invoked concurrently from several threads.  The pipeline is then linked on
+// the calling thread.
+//
+// Writes one result per stage to results[0] through results[num_stages - 1],
+// in stage order; each must be released with shaderc_result_release.  A
+// result holds the module of its stage, and the messages of parsing that
+// stage followed by those of linking the pipeline.  Unless the whole pipeline
+// compiles, no result has a module and none reports success.  Returns the
+// status of the pipeline as a whole.
+SHADERC_EXPORT shaderc_compilation_status shaderc_compile_pipeline_into_spv(
+    const shaderc_compiler_t compiler, const shaderc_pipeline_stage* stages,
+    size_t num_stages, const shaderc_compile_options_t additional_options,
+    shaderc_compilation_result_t* results);
+
 // Takes an assembly string of the format defined in the SPIRV-Tools project
 // (https://github.com/KhronosGroup/SPIRV-Tools/blob/master/syntax.md),
 // assembles it into SPIR-V binary and a shaderc_compilation_result will be
@@ -602,6 +877,61 @@ SHADERC_EXPORT const char* shaderc_result_get_bytes(const shaderc_compilation_re
 SHADERC_EXPORT const char* shaderc_result_get_error_message(
     const shaderc_compilation_result_t result);
 
+// How long one phase of a compilation took.
+typedef struct {
+  // The phase, e.g. "parse", or a step within one, e.g.
+  // "optimize/eliminate-dead-code-aggressive".  See
+  // shaderc_result_get_phase_timings().
+  const char* name;
+  // Elapsed wall clock time.
+  double wall_seconds;
+  // Bytes allocated from glslang's pool allocator.  Zero for phases that run
+  // outside glslang, whose heap allocations are not measured.
+  size_t pool_bytes;
+} shaderc_phase_timing;
+
+// Returns the number of phase timings recorded for the compilation, and points
+// *timings at them.  The array is owned by the result.  Timings are only
+// recorded with shaderc_compile_options_set_collect_phase_timings(), and are
+// listed in the order the phases ran:
+//   "preprocess"      only when preprocessing runs apart from parsing, for
+//                     preprocessing-only output or to infer the shader stage
+//   "parse"           preprocessing, parsing and semantic checks
+//   "link", "map-io"  linking and I/O mapping of the single-shader program
+//   "generate-spirv"  translation of the AST to SPIR-V
+//   "optimize"        optimization or legalization, including validation of
+//                     the input, followed by one "optimize/<step>" entry per
+//                     optimizer pass and for "read-module" and "write-module"
+//   "disassemble"     only for assembly output
+// A result taken from the compilation cache has a single "cache-lookup".
+SHADERC_EXPORT size_t shaderc_result_get_phase_timings(
+    const shaderc_compilation_result_t result,
+    const shaderc_phase_timing** timings);
+
+// Returns the number of files included by a source scanned with
+// shaderc_scan_dependencies(), and points *files at their names, each listed
+// once in the order first included.  The array is owned by the result.  Other
+// results have none.
+SHADERC_EXPORT size_t shaderc_result_get_included_files(
+    const shaderc_compilation_result_t result, const char* const** files);
+
+// Like shaderc_result_get_included_files(), but for the macros tested by
+// #if, #elif, #ifdef, #ifndef or defined(), whether defined or not.
+SHADERC_EXPORT size_t shaderc_result_get_tested_macros(
+    const shaderc_compilation_result_t result, const char* const** macros);
+
+// Returns the layout table of a successful compilation with
+// shaderc_compile_options_set_generate_layout_table(), and sets *size to its
+// size in bytes.  The table is described in shaderc/layout_table.h, is owned
+// by the result, and is 4-byte aligned.  It lists the descriptors, push
+// constants, inputs and outputs as declared, after bindings and locations are
+// assigned, but before optimization, so it may include some the SPIR-V module
+// no longer uses.  Each stage of a pipeline compiled by
+// shaderc_compile_pipeline_into_spv() has the table of the whole pipeline.
+// Returns null, with *size set to 0, if the result has no table.
+SHADERC_EXPORT const void* shaderc_result_get_layout_table(
+    const shaderc_compilation_result_t result, size_t* size);
+
 // Provides the version & revision of the SPIR-V which will be produced
 SHADERC_EXPORT void shaderc_get_spv_version(unsigned int* version, unsigned int* revision);
 
@@ -15,6 +15,7 @@
 #ifndef SHADERC_SHADERC_HPP_
 #define SHADERC_SHADERC_HPP_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -121,6 +122,56 @@ class CompilationResult {
     return shaderc_result_get_num_errors(compilation_result_);
   }
 
+  // Returns how long each phase of the compilation took, as described in
+  // shaderc_result_get_phase_timings().  The names point into this result.
+  std::vector<shaderc_phase_timing> GetPhaseTimings() const {
+    if (!compilation_result_) {
+      return {};
+    }
+    const shaderc_phase_timing* timings = nullptr;
+    const size_t count =
+        shaderc_result_get_phase_timings(compilation_result_, &timings);
+    return std::vector<shaderc_phase_timing>(timings, timings + count);
+  }
+
+  // Returns the files included by a source scanned with
+  // Compiler::ScanDependencies(), as described in
+  // shaderc_result_get_included_files().
+  std::vector<std::string> GetIncludedFiles() const {
+    if (!compilation_result_) {
+      return {};
+    }
+    const char* const* files = nullptr;
+    const size_t count =
+        shaderc_result_get_included_files(compilation_result_, &files);
+    return std::vector<std::string>(files, files + count);
+  }
+
+  // Returns the macros tested by a source scanned with
+  // Compiler::ScanDependencies(), as described in
+  // shaderc_result_get_tested_macros().
+  std::vector<std::string> GetTestedMacros() const {
+    if (!compilation_result_) {
+      return {};
+    }
+    const char* const* macros = nullptr;
+    const size_t count =
+        shaderc_result_get_tested_macros(compilation_result_, &macros);
+    return std::vector<std::string>(macros, macros + count);
+  }
+
+  // Returns the layout table of the compilation, as described in
+  // shaderc_result_get_layout_table(), or an empty vector if there is none.
+  std::vector<uint32_t> GetLayoutTable() const {
+    if (!compilation_result_) {
+      return {};
+    }
+    size_t size = 0;
+    const uint32_t* table = static_cast<const uint32_t*>(
+        shaderc_result_get_layout_table(compilation_result_, &size));
+    return std::vector<uint32_t>(table, table + size / sizeof(uint32_t));
+  }
+
  private:
   CompilationResult(const CompilationResult& other) = delete;
   CompilationResult& operator=(const CompilationResult& other) = delete;
@@ -135,6 +186,80 @@ using SpvCompilationResult = CompilationResult<uint32_t>;
 using AssemblyCompilationResult = CompilationResult<char>;
 // Preprocessed source text.
 using PreprocessedSourceCompilationResult = CompilationResult<char>;
+// The dependencies of a source, with a Makefile rule as output if requested.
+using DependencyScanResult = CompilationResult<char>;
+
+// A cache of compilation results which can be shared between CompileOptions,
+// as described in shaderc_compilation_cache_initialize().
+class CompilationCache {
+ public:
+  // Creates an in-memory cache.  If directory is not empty, results are also
+  // persisted as files in that directory, which must already exist.
+  explicit CompilationCache(const std::string& directory = "")
+      : cache_(shaderc_compilation_cache_initialize(directory.c_str())) {}
+  ~CompilationCache() { shaderc_compilation_cache_release(cache_); }
+
+  CompilationCache(CompilationCache&& other) : cache_(other.cache_) {
+    other.cache_ = nullptr;
+  }
+
+  bool IsValid() const { return cache_ != nullptr; }
+
+ private:
+  CompilationCache(const CompilationCache&) = delete;
+  CompilationCache& operator=(const CompilationCache&) = delete;
+
+  shaderc_compilation_cache_t cache_;
+
+  friend class CompileOptions;
+};
+
+// A cache of #included file contents which can be shared between
+// CompileOptions, as described in shaderc_include_file_cache_initialize().
+class IncludeFileCache {
+ public:
+  IncludeFileCache() : cache_(shaderc_include_file_cache_initialize()) {}
+  ~IncludeFileCache() { shaderc_include_file_cache_release(cache_); }
+
+  IncludeFileCache(IncludeFileCache&& other) : cache_(other.cache_) {
+    other.cache_ = nullptr;
+  }
+
+  bool IsValid() const { return cache_ != nullptr; }
+
+ private:
+  IncludeFileCache(const IncludeFileCache&) = delete;
+  IncludeFileCache& operator=(const IncludeFileCache&) = delete;
+
+  shaderc_include_file_cache_t cache_;
+
+  friend class CompileOptions;
+};
+
+// A header set whose macros can be shared between compilations, as described
+// in shaderc_precompiled_preamble_create().
+class PrecompiledPreamble {
+ public:
+  PrecompiledPreamble(const std::string& text, const std::string& name)
+      : preamble_(shaderc_precompiled_preamble_create(
+            text.data(), text.size(), name.c_str())) {}
+  ~PrecompiledPreamble() { shaderc_precompiled_preamble_release(preamble_); }
+
+  PrecompiledPreamble(PrecompiledPreamble&& other)
+      : preamble_(other.preamble_) {
+    other.preamble_ = nullptr;
+  }
+
+  bool IsValid() const { return preamble_ != nullptr; }
+
+ private:
+  PrecompiledPreamble(const PrecompiledPreamble&) = delete;
+  PrecompiledPreamble& operator=(const PrecompiledPreamble&) = delete;
+
+  shaderc_precompiled_preamble_t preamble_;
+
+  friend class CompileOptions;
+};
 
 // Contains any options that can have default values for a compilation.
 class CompileOptions {
@@ -178,6 +303,33 @@ class CompileOptions {
     shaderc_compile_options_set_optimization_level(options_, level);
   }
 
+  // Sets how the front end's pool allocator gets memory, as described in
+  // shaderc_compile_options_set_pool_allocator().
+  void SetPoolAllocator(size_t page_size, bool huge_pages,
+                        size_t recycle_bytes) {
+    shaderc_compile_options_set_pool_allocator(options_, page_size, huge_pages,
+                                               recycle_bytes);
+  }
+
+  // Sets whether compiling threads keep the pool allocator's memory between
+  // compilations, as described in
+  // shaderc_compile_options_set_reuse_thread_arenas().
+  void SetReuseThreadArenas(bool enable) {
+    shaderc_compile_options_set_reuse_thread_arenas(options_, enable);
+  }
+
+  // Sets whether compilations record how long each phase takes, as described
+  // in shaderc_compile_options_set_collect_phase_timings().
+  void SetCollectPhaseTimings(bool enable) {
+    shaderc_compile_options_set_collect_phase_timings(options_, enable);
+  }
+
+  // Sets whether compilations produce a layout table, as described in
+  // shaderc_compile_options_set_generate_layout_table().
+  void SetGenerateLayoutTable(bool enable) {
+    shaderc_compile_options_set_generate_layout_table(options_, enable);
+  }
+
   // A C++ version of the libshaderc includer interface.
   class IncluderInterface {
    public:
@@ -214,6 +366,21 @@ class CompileOptions {
         includer_.get());
   }
 
+  // Makes compilations with these options read #included files from the file
+  // system through the given cache, instead of calling an includer, as
+  // described in shaderc_compile_options_set_include_file_cache().  The cache
+  // may be destroyed before these options; it stays alive for as long as it
+  // is in use.
+  void SetIncludeFileCache(const IncludeFileCache& cache) {
+    shaderc_compile_options_set_include_file_cache(options_, cache.cache_);
+  }
+
+  // Appends a directory to the search path for #included files read from the
+  // file system.
+  void AddIncludeDirectory(const std::string& directory) {
+    shaderc_compile_options_add_include_directory(options_, directory.c_str());
+  }
+
   // Forces the GLSL language version and profile to a given pair. The version
   // number is the same as would appear in the #version annotation in the
   // source. Version and profile specified here overrides the #version
@@ -373,6 +540,30 @@ class CompileOptions {
     shaderc_compile_options_set_nan_clamp(options_, enable);
   }
 
+  // Sets the cache used by compilations with these options, as described in
+  // shaderc_compile_options_set_cache().  The cache may be destroyed before
+  // these options; it stays alive for as long as it is in use.
+  void SetCache(const CompilationCache& cache) {
+    shaderc_compile_options_set_cache(options_, cache.cache_);
+  }
+
+  // Disables caching for compilations with these options.
+  void ClearCache() { shaderc_compile_options_set_cache(options_, nullptr); }
+
+  // Sets the precompiled preamble used by compilations with these options, as
+  // described in shaderc_compile_options_set_precompiled_preamble().  The
+  // preamble may be destroyed before these options; it stays alive for as
+  // long as it is in use.
+  void SetPrecompiledPreamble(const PrecompiledPreamble& preamble) {
+    shaderc_compile_options_set_precompiled_preamble(options_,
+                                                     preamble.preamble_);
+  }
+
+  // Stops compilations with these options from using a precompiled preamble.
+  void ClearPrecompiledPreamble() {
+    shaderc_compile_options_set_precompiled_preamble(options_, nullptr);
+  }
+
  private:
   CompileOptions& operator=(const CompileOptions& other) = delete;
   shaderc_compile_options_t options_;
@@ -381,6 +572,28 @@ class CompileOptions {
   friend class Compiler;
 };
 
+// One compilation in a batch passed to Compiler::CompileBatch.  The fields
+// have the same meaning as the parameters of Compiler::CompileGlslToSpv.  A
+// null options pointer means default options; several jobs may point at the
+// same CompileOptions object, which must outlive the call.
+struct CompileJob {
+  std::string source_text;
+  shaderc_shader_kind shader_kind = shaderc_glsl_infer_from_source;
+  std::string input_file_name;
+  std::string entry_point_name = "main";
+  const CompileOptions* options = nullptr;
+};
+
+// One stage of a pipeline passed to Compiler::CompilePipeline.  The fields
+// have the same meaning as the parameters of Compiler::CompileGlslToSpv,
+// except that shader_kind must name a specific stage.
+struct PipelineStage {
+  std::string source_text;
+  shaderc_shader_kind shader_kind = shaderc_glsl_infer_from_source;
+  std::string input_file_name;
+  std::string entry_point_name = "main";
+};
+
 // The compilation context for compiling source to SPIR-V.
 class Compiler {
  public:
@@ -394,6 +607,13 @@ class Compiler {
 
   bool IsValid() const { return compiler_ != nullptr; }
 
+  // Keeps the process-wide compiler state alive until the process exits, so
+  // that creating and destroying Compiler objects is cheap and does not
+  // synchronize across threads.
+  static void KeepProcessInitialized() {
+    shaderc_compiler_keep_process_initialized();
+  }
+
   // Compiles the given source GLSL and returns a SPIR-V binary module
   // compilation result.
   // The source_text parameter must be a valid pointer.
@@ -493,6 +713,84 @@ class Compiler {
                             input_file_name);
   }
 
+  // Compiles the given source shader like the first CompileGlslToSpv method,
+  // but writes the SPIR-V binary into the caller-owned buffer of buffer_size
+  // bytes when it fits, as described in shaderc_compile_into_spv_buffer().
+  // The binary is in buffer exactly when the result's length in bytes is at
+  // most buffer_size; otherwise the result holds it.  The buffer must
+  // outlive the result and be 4-byte aligned.
+  SpvCompilationResult CompileGlslToSpvBuffer(
+      const char* source_text, size_t source_text_size,
+      shaderc_shader_kind shader_kind, const char* input_file_name,
+      const char* entry_point_name, const CompileOptions& options,
+      void* buffer, size_t buffer_size) const {
+    shaderc_compilation_result_t compilation_result =
+        shaderc_compile_into_spv_buffer(
+            compiler_, source_text, source_text_size, shader_kind,
+            input_file_name, entry_point_name, options.options_, buffer,
+            buffer_size);
+    return SpvCompilationResult(compilation_result);
+  }
+
+  // Sets the number of worker threads CompileBatch uses.  Zero, the default,
+  // means one worker per hardware thread.
+  void SetBatchThreadCount(size_t num_threads) {
+    shaderc_compiler_set_batch_thread_count(compiler_, num_threads);
+  }
+
+  // Compiles every job into a SPIR-V binary module in parallel and returns
+  // the results in job order.  Each result is the same as CompileGlslToSpv
+  // would have produced for that job.  Include callbacks set on the options
+  // may be invoked concurrently from several threads.
+  std::vector<SpvCompilationResult> CompileBatch(
+      const std::vector<CompileJob>& jobs) const {
+    std::vector<shaderc_compile_job> c_jobs(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      c_jobs[i].source_text = jobs[i].source_text.data();
+      c_jobs[i].source_text_size = jobs[i].source_text.size();
+      c_jobs[i].shader_kind = jobs[i].shader_kind;
+      c_jobs[i].input_file_name = jobs[i].input_file_name.c_str();
+      c_jobs[i].entry_point_name = jobs[i].entry_point_name.c_str();
+      c_jobs[i].options = jobs[i].options ? jobs[i].options->options_ : nullptr;
+    }
+    std::vector<shaderc_compilation_result_t> c_results(jobs.size());
+    shaderc_compile_batch_into_spv(compiler_, c_jobs.data(), c_jobs.size(),
+                                   c_results.data());
+    std::vector<SpvCompilationResult> results;
+    results.reserve(c_results.size());
+    for (shaderc_compilation_result_t result : c_results) {
+      results.emplace_back(result);
+    }
+    return results;
+  }
+
+  // Compiles the stages of one pipeline into SPIR-V binary modules linked as
+  // one program, and returns the result of each stage in stage order.  The
+  // stages are parsed in parallel on the CompileBatch workers; see
+  // shaderc_compile_pipeline_into_spv for the details.
+  std::vector<SpvCompilationResult> CompilePipeline(
+      const std::vector<PipelineStage>& stages,
+      const CompileOptions& options) const {
+    std::vector<shaderc_pipeline_stage> c_stages(stages.size());
+    for (size_t i = 0; i < stages.size(); ++i) {
+      c_stages[i].source_text = stages[i].source_text.data();
+      c_stages[i].source_text_size = stages[i].source_text.size();
+      c_stages[i].shader_kind = stages[i].shader_kind;
+      c_stages[i].input_file_name = stages[i].input_file_name.c_str();
+      c_stages[i].entry_point_name = stages[i].entry_point_name.c_str();
+    }
+    std::vector<shaderc_compilation_result_t> c_results(stages.size());
+    shaderc_compile_pipeline_into_spv(compiler_, c_stages.data(),
+                                      c_stages.size(), options.options_,
+                                      c_results.data());
+    std::vector<SpvCompilationResult> results;
+    results.reserve(c_results.size());
+    for (shaderc_compilation_result_t result : c_results) {
+      results.emplace_back(result);
+    }
+    return results;
+  }
+
   // Assembles the given SPIR-V assembly and returns a SPIR-V binary module
   // compilation result.
   // The assembly should follow the syntax defined in the SPIRV-Tools project
@@ -609,7 +907,54 @@ class Compiler {
                           input_file_name, options);
   }
 
+  // Preprocesses the given source GLSL like PreprocessGlsl, but hands the
+  // preprocessed text to sink in pieces as it is produced.  The returned
+  // result carries the status and messages but no output.  See
+  // shaderc_compile_into_preprocessed_text_callback for details.
+  PreprocessedSourceCompilationResult PreprocessGlslToSink(
+      const char* source_text, size_t source_text_size,
+      shaderc_shader_kind shader_kind, const char* input_file_name,
+      const CompileOptions& options,
+      const std::function<void(const char* text, size_t text_size)>& sink)
+      const {
+    shaderc_compilation_result_t compilation_result =
+        shaderc_compile_into_preprocessed_text_callback(
+            compiler_, source_text, source_text_size, shader_kind,
+            input_file_name, "main", options.options_, &CallSink,
+            const_cast<void*>(static_cast<const void*>(&sink)));
+    return PreprocessedSourceCompilationResult(compilation_result);
+  }
+
+  // Finds the files the given source includes and the macros it tests, as
+  // described in shaderc_scan_dependencies().  If depfile_target is not
+  // nullptr, the output of the result is a Makefile rule for it.
+  DependencyScanResult ScanDependencies(
+      const char* source_text, size_t source_text_size,
+      const char* input_file_name, const CompileOptions& options,
+      const char* depfile_target = nullptr) const {
+    shaderc_compilation_result_t compilation_result =
+        shaderc_scan_dependencies(compiler_, source_text, source_text_size,
+                                  input_file_name, depfile_target,
+                                  options.options_);
+    return DependencyScanResult(compilation_result);
+  }
+
+  // Like the previous ScanDependencies method, but the source is provided
+  // as a std::string.
+  DependencyScanResult ScanDependencies(
+      const std::string& source_text, const char* input_file_name,
+      const CompileOptions& options,
+      const char* depfile_target = nullptr) const {
+    return ScanDependencies(source_text.data(), source_text.size(),
+                            input_file_name, options, depfile_target);
+  }
+
  private:
+  static void CallSink(void* user_data, const char* text, size_t text_size) {
+    (*static_cast<const std::function<void(const char*, size_t)>*>(
+        user_data))(text, text_size);
+  }
+
   Compiler(const Compiler&) = delete;
   Compiler& operator=(const Compiler& other) = delete;
 
@@ -235,6 +235,13 @@ class SPIRV_TOOLS_EXPORT Optimizer {
   // |out| output stream.
   Optimizer& SetTimeReport(std::ostream* out);
 
+  // Sets a list that Run() appends the name and wall time, in seconds, of
+  // each pass to, in the order they run.  Reading (and validating) the input
+  // is recorded as "read-module", and writing the output as "write-module".
+  // If |timings| is null, nothing is recorded.
+  Optimizer& SetPassTimings(
+      std::vector<std::pair<std::string, double>>* timings);
+
   // Sets the option to validate the module after each pass.
   Optimizer& SetValidateAfterAll(bool validate);
 
@@ -0,0 +1,425 @@
+// Copyright 2026 The Shaderc Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libshaderc_util/compilation_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+using shaderc_util::CompilationCache;
+
+// Identifies a cache entry file, followed by the format version.  Bump the
+// version whenever the encoding below changes.
+const char kEntryMagic[4] = {'S', 'H', 'C', 'C'};
+const uint32_t kEntryFormatVersion = 2;
+
+// Appends the object representation of value to *out.
+template <typename T>
+void WriteValue(std::string* out, const T& value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Appends a length-prefixed string to *out.
+void WriteString(std::string* out, const std::string& str) {
+  WriteValue(out, static_cast<uint64_t>(str.size()));
+  out->append(str);
+}
+
+// A bounds-checked cursor over an encoded entry.  Every read returns false
+// instead of reading past the end of the input.
+class Reader {
+ public:
+  explicit Reader(const std::string& data) : data_(data), pos_(0) {}
+
+  template <typename T>
+  bool ReadValue(T* value) {
+    return ReadBytes(value, sizeof(T));
+  }
+
+  bool ReadString(std::string* str) {
+    uint64_t size = 0;
+    if (!ReadValue(&size) || data_.size() - pos_ < size) return false;
+    str->assign(data_.data() + pos_, static_cast<size_t>(size));
+    pos_ += static_cast<size_t>(size);
+    return true;
+  }
+
+  bool ReadBytes(void* out, size_t size) {
+    if (data_.size() - pos_ < size) return false;
+    std::memcpy(out, data_.data() + pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+  bool AtEnd() const { return pos_ == data_.size(); }
+
+ private:
+  const std::string& data_;
+  size_t pos_;
+};
+
+// Serializes entry into the on-disk format.
+std::string EncodeEntry(const CompilationCache::Entry& entry) {
+  std::string out(kEntryMagic, sizeof(kEntryMagic));
+  WriteValue(&out, kEntryFormatVersion);
+  WriteValue(&out, static_cast<uint64_t>(entry.dependencies.size()));
+  for (const auto& dependency : entry.dependencies) {
+    WriteString(&out, dependency.requested_source);
+    WriteString(&out, dependency.requesting_source);
+    WriteValue(&out, static_cast<uint32_t>(dependency.type));
+    WriteValue(&out, dependency.include_depth);
+    WriteString(&out, dependency.digest);
+  }
+  WriteValue(&out, entry.output_data_size_in_bytes);
+  WriteValue(&out, static_cast<uint64_t>(entry.output_data.size()));
+  out.append(reinterpret_cast<const char*>(entry.output_data.data()),
+             entry.output_data.size() * sizeof(uint32_t));
+  WriteString(&out, entry.messages);
+  WriteValue(&out, entry.num_warnings);
+  return out;
+}
+
+// Deserializes an entry from the on-disk format.  Returns false if data is
+// truncated, from another format version, or otherwise malformed.
+bool DecodeEntry(const std::string& data, CompilationCache::Entry* entry) {
+  Reader reader(data);
+  char magic[sizeof(kEntryMagic)];
+  uint32_t version = 0;
+  if (!reader.ReadBytes(magic, sizeof(magic)) ||
+      std::memcmp(magic, kEntryMagic, sizeof(magic)) != 0 ||
+      !reader.ReadValue(&version) || version != kEntryFormatVersion) {
+    return false;
+  }
+
+  uint64_t num_dependencies = 0;
+  if (!reader.ReadValue(&num_dependencies)) return false;
+  entry->dependencies.clear();
+  for (uint64_t i = 0; i < num_dependencies; ++i) {
+    CompilationCache::Dependency dependency;
+    uint32_t type = 0;
+    if (!reader.ReadString(&dependency.requested_source) ||
+        !reader.ReadString(&dependency.requesting_source) ||
+        !reader.ReadValue(&type) ||
+        !reader.ReadValue(&dependency.include_depth) ||
+        !reader.ReadString(&dependency.digest)) {
+      return false;
+    }
+    dependency.type =
+        static_cast<shaderc_util::CountingIncluder::IncludeType>(type);
+    entry->dependencies.push_back(std::move(dependency));
+  }
+
+  uint64_t num_words = 0;
+  if (!reader.ReadValue(&entry->output_data_size_in_bytes) ||
+      !reader.ReadValue(&num_words) ||
+      num_words > data.size() / sizeof(uint32_t)) {
+    return false;
+  }
+  entry->output_data.resize(static_cast<size_t>(num_words));
+  return reader.ReadBytes(entry->output_data.data(),
+                          entry->output_data.size() * sizeof(uint32_t)) &&
+         reader.ReadString(&entry->messages) &&
+         reader.ReadValue(&entry->num_warnings) && reader.AtEnd();
+}
+
+// Returns about how much memory key and entry take up.
+size_t GetMemorySize(const std::string& key,
+                     const CompilationCache::Entry& entry) {
+  size_t size = sizeof(entry) + key.size() +
+                entry.output_data.size() * sizeof(uint32_t) +
+                entry.messages.size();
+  for (const auto& dependency : entry.dependencies) {
+    size += sizeof(dependency) + dependency.requested_source.size() +
+            dependency.requesting_source.size() + dependency.digest.size();
+  }
+  return size;
+}
+
+// Resolves the include request described by dependency through includer.
+glslang::TShader::Includer::IncludeResult* ResolveDependency(
+    shaderc_util::CountingIncluder& includer,
+    const CompilationCache::Dependency& dependency) {
+  const char* requested = dependency.requested_source.c_str();
+  const char* requesting = dependency.requesting_source.c_str();
+  const size_t depth = static_cast<size_t>(dependency.include_depth);
+  if (dependency.type == shaderc_util::CountingIncluder::IncludeType::System) {
+    return includer.includeSystem(requested, requesting, depth);
+  }
+  return includer.includeLocal(requested, requesting, depth);
+}
+
+}  // anonymous namespace
+
+namespace shaderc_util {
+
+CacheKeyHasher::CacheKeyHasher()
+    : state_{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+             0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19},
+      block_size_(0),
+      total_size_(0) {}
+
+void CacheKeyHasher::Add(const void* data, size_t size) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  total_size_ += size;
+  while (size > 0) {
+    const size_t count = std::min(size, sizeof(block_) - block_size_);
+    std::memcpy(block_ + block_size_, bytes, count);
+    block_size_ += count;
+    bytes += count;
+    size -= count;
+    if (block_size_ == sizeof(block_)) ProcessBlock();
+  }
+}
+
+std::string CacheKeyHasher::Digest() const {
+  // Pad a copy, so that more bytes can still be added to this one.
+  CacheKeyHasher padded(*this);
+  const uint64_t size_in_bits = total_size_ * 8;
+  const unsigned char kOne = 0x80;
+  const unsigned char kZero = 0;
+  padded.Add(&kOne, 1);
+  while (padded.block_size_ != sizeof(block_) - sizeof(size_in_bits)) {
+    padded.Add(&kZero, 1);
+  }
+  unsigned char size_bytes[sizeof(size_in_bits)];
+  for (size_t i = 0; i < sizeof(size_bytes); ++i) {
+    size_bytes[i] = static_cast<unsigned char>(size_in_bits >> (56 - 8 * i));
+  }
+  padded.Add(size_bytes, sizeof(size_bytes));
+
+  char buffer[65];
+  for (int i = 0; i < 8; ++i) {
+    std::snprintf(buffer + 8 * i, 9, "%08x",
+                  static_cast<unsigned>(padded.state_[i]));
+  }
+  return std::string(buffer, 64);
+}
+
+void CacheKeyHasher::ProcessBlock() {
+  static const uint32_t kRoundConstants[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+      0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+      0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+      0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+      0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+      0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+      0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+      0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+      0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+  auto rotate_right = [](uint32_t value, int count) {
+    return (value >> count) | (value << (32 - count));
+  };
+
+  uint32_t schedule[64];
+  for (int i = 0; i < 16; ++i) {
+    schedule[i] = (uint32_t(block_[4 * i]) << 24) |
+                  (uint32_t(block_[4 * i + 1]) << 16) |
+                  (uint32_t(block_[4 * i + 2]) << 8) |
+                  uint32_t(block_[4 * i + 3]);
+  }
+  for (int i = 16; i < 64; ++i) {
+    const uint32_t s0 = rotate_right(schedule[i - 15], 7) ^
+                        rotate_right(schedule[i - 15], 18) ^
+                        (schedule[i - 15] >> 3);
+    const uint32_t s1 = rotate_right(schedule[i - 2], 17) ^
+                        rotate_right(schedule[i - 2], 19) ^
+                        (schedule[i - 2] >> 10);
+    schedule[i] = schedule[i - 16] + s0 + schedule[i - 7] + s1;
+  }
+
+  uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+  uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+  for (int i = 0; i < 64; ++i) {
+    const uint32_t s1 =
+        rotate_right(e, 6) ^ rotate_right(e, 11) ^ rotate_right(e, 25);
+    const uint32_t choice = (e & f) ^ (~e & g);
+    const uint32_t temp1 = h + s1 + choice + kRoundConstants[i] + schedule[i];
+    const uint32_t s0 =
+        rotate_right(a, 2) ^ rotate_right(a, 13) ^ rotate_right(a, 22);
+    const uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+    const uint32_t temp2 = s0 + majority;
+    h = g;
+    g = f;
+    f = e;
+    e = d + temp1;
+    d = c;
+    c = b;
+    b = a;
+    a = temp1 + temp2;
+  }
+  state_[0] += a;
+  state_[1] += b;
+  state_[2] += c;
+  state_[3] += d;
+  state_[4] += e;
+  state_[5] += f;
+  state_[6] += g;
+  state_[7] += h;
+  block_size_ = 0;
+}
+
+std::string GetIncludeResultDigest(
+    const glslang::TShader::Includer::IncludeResult* result) {
+  CacheKeyHasher hasher;
+  if (result) {
+    hasher.Add(result->headerName);
+    hasher.Add(string_piece(result->headerData,
+                            result->headerData + result->headerLength));
+  }
+  return hasher.Digest();
+}
+
+bool CompilationCache::Lookup(const std::string& key,
+                              CountingIncluder& includer, Entry* entry) {
+  bool found = false;
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      *entry = it->second.entry;
+      lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+      found = true;
+    }
+  }
+
+  if (!found) {
+    if (directory_.empty() || !ReadEntry(key, entry)) return false;
+    const std::lock_guard<std::mutex> lock(mutex_);
+    KeepInMemory(key, *entry);
+  }
+
+  // Replaying the requests in order is sufficient: as long as every include
+  // so far resolved to identical contents, the preprocessor would make exactly
+  // the same next request.
+  for (const auto& dependency : entry->dependencies) {
+    glslang::TShader::Includer::IncludeResult* result =
+        ResolveDependency(includer, dependency);
+    const bool unchanged =
+        result && !result->headerName.empty() &&
+        GetIncludeResultDigest(result) == dependency.digest;
+    includer.releaseInclude(result);
+    if (!unchanged) return false;
+  }
+  return true;
+}
+
+void CompilationCache::Insert(const std::string& key, const Entry& entry) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    KeepInMemory(key, entry);
+  }
+  if (!directory_.empty()) WriteEntry(key, entry);
+}
+
+void CompilationCache::Clear() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  lru_.clear();
+  memory_size_ = 0;
+}
+
+void CompilationCache::KeepInMemory(const std::string& key,
+                                    const Entry& entry) {
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    memory_size_ -= it->second.size;
+    lru_.erase(it->second.lru_position);
+    entries_.erase(it);
+  }
+
+  // An entry over the whole budget would only push out all the others.
+  const size_t size = GetMemorySize(key, entry);
+  if (size > memory_budget_) return;
+  while (memory_size_ + size > memory_budget_) {
+    auto last = entries_.find(lru_.back());
+    memory_size_ -= last->second.size;
+    entries_.erase(last);
+    lru_.pop_back();
+  }
+  lru_.push_front(key);
+  entries_.emplace(key, MemoryEntry{entry, size, lru_.begin()});
+  memory_size_ += size;
+}
+
+std::string CompilationCache::GetEntryPath(const std::string& key) const {
+  return (std::filesystem::path(directory_) / (key + ".spvcache")).string();
+}
+
+bool CompilationCache::ReadEntry(const std::string& key, Entry* entry) const {
+  std::ifstream file(GetEntryPath(key), std::ios_base::binary);
+  if (!file) return false;
+  const std::string data((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+  return DecodeEntry(data, entry);
+}
+
+void CompilationCache::WriteEntry(const std::string& key,
+                                  const Entry& entry) const {
+  // Write to a uniquely named temporary file first and then move it into
+  // place, so that concurrent readers in this or other processes never see a
+  // partially written entry.
+  static std::atomic<uint64_t> temp_counter(0);
+  std::ostringstream temp_name;
+  temp_name << GetEntryPath(key) << ".tmp" << std::hex
+            << reinterpret_cast<uintptr_t>(this) << "-" << temp_counter++;
+
+  const std::string data = EncodeEntry(entry);
+  {
+    std::ofstream file(temp_name.str(), std::ios_base::binary);
+    if (!file) return;
+    file.write(data.data(), data.size());
+    if (!file.good()) {
+      file.close();
+      std::remove(temp_name.str().c_str());
+      return;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temp_name.str(), GetEntryPath(key), error);
+  if (error) std::remove(temp_name.str().c_str());
+}
+
+glslang::TShader::Includer::IncludeResult*
+DependencyRecordingIncluder::include_delegate(const char* requested_source,
+                                              const char* requesting_source,
+                                              IncludeType type,
+                                              size_t include_depth) {
+  glslang::TShader::Includer::IncludeResult* result =
+      type == IncludeType::System
+          ? includer_.includeSystem(requested_source, requesting_source,
+                                    include_depth)
+          : includer_.includeLocal(requested_source, requesting_source,
+                                   include_depth);
+
+  CompilationCache::Dependency dependency;
+  dependency.requested_source = requested_source ? requested_source : "";
+  dependency.requesting_source = requesting_source ? requesting_source : "";
+  dependency.type = type;
+  dependency.include_depth = include_depth;
+  dependency.digest = GetIncludeResultDigest(result);
+  dependencies_.push_back(std::move(dependency));
+  return result;
+}
+
+}  // namespace shaderc_util
@@ -14,12 +14,17 @@
 
 #include "libshaderc_util/compiler.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <iomanip>
+#include <memory>
 #include <sstream>
 #include <thread>
 #include <tuple>
 
+#include "glslang/Include/PoolAlloc.h"
 #include "glslangSPIRV/GlslangToSpv.h"
 #include "libshaderc_util/format.h"
 #include "libshaderc_util/io_shaderc.h"
@@ -28,6 +33,7 @@
 #include "libshaderc_util/shader_stage.h"
 #include "libshaderc_util/spirv_tools_wrapper.h"
 #include "libshaderc_util/string_piece.h"
+#include "libshaderc_util/thread_pool.h"
 #include "libshaderc_util/version_profile.h"
 #include "spirv-tools/libspirv.hpp"
 
@@ -105,50 +111,368 @@ EShMessages GetMessageRules(shaderc_util::Compiler::TargetEnv env,
   return result;
 }
 
+// Appends the wall time of consecutive compilation phases to a list of
+// timings.  Does nothing if there is no list.
+class PhaseTimer {
+ public:
+  explicit PhaseTimer(
+      std::vector<shaderc_util::Compiler::PhaseTiming>* timings)
+      : timings_(timings), start_(std::chrono::steady_clock::now()) {}
+
+  // Records the time since the previous call, or since construction, as the
+  // phase called name.
+  void Record(const std::string& name, size_t pool_bytes = 0) {
+    if (!timings_) return;
+    const auto now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> elapsed = now - start_;
+    timings_->push_back({name, elapsed.count(), pool_bytes});
+    start_ = now;
+  }
+
+  // Returns the list that pass timings of the optimizer can be appended to,
+  // or null if timings are not collected.
+  std::vector<std::pair<std::string, double>>* pass_timings() {
+    return timings_ ? &pass_timings_ : nullptr;
+  }
+
+  // Records the pass timings collected so far as steps of the phase called
+  // name, and clears them.
+  void RecordPasses(const std::string& name) {
+    if (!timings_) return;
+    for (const auto& pass : pass_timings_) {
+      timings_->push_back({name + "/" + pass.first, pass.second, 0});
+    }
+    pass_timings_.clear();
+  }
+
+ private:
+  std::vector<shaderc_util::Compiler::PhaseTiming>* timings_;
+  std::chrono::steady_clock::time_point start_;
+  std::vector<std::pair<std::string, double>> pass_timings_;
+};
+
+// Returns log preceded by the warnings in preprocessing_log that it does not
+// contain, such as those about macros, which are gone once the source is
+// preprocessed.  Both are glslang info logs.
+std::string AddPreprocessingWarnings(const string_piece& preprocessing_log,
+                                     const string_piece& log) {
+  std::string result;
+  for (const string_piece& line :
+       preprocessing_log.get_fields('\n', /* keep_delimiter = */ true)) {
+    if (line.starts_with("WARNING: ") && log.find(line) == string_piece::npos) {
+      result.append(line.begin(), line.end());
+    }
+  }
+  result.append(log.begin(), log.end());
+  return result;
+}
+
+// Returns the number of bytes allocated so far from the calling thread's
+// glslang pool.
+size_t ThreadPoolBytes() {
+  return glslang::GetThreadPoolAllocator().getTotalBytes();
+}
+
+// Sets the pool allocator options for the glslang shaders and programs the
+// calling thread constructs while this is in scope.  Constructed before them
+// and destroyed after them, so on the way out it also resets the thread's
+// current pool, which glslang leaves pointing at the last of their pools.
+// Otherwise the next compilation on the thread would start out allocating
+// from a destroyed pool, whose pages may by then belong to a recycled arena.
+class ScopedPoolAllocatorOptions {
+ public:
+  explicit ScopedPoolAllocatorOptions(
+      const glslang::TPoolAllocatorOptions& options)
+      : previous_options_(glslang::GetThreadPoolAllocatorOptions()) {
+    glslang::SetThreadPoolAllocatorOptions(options);
+  }
+  ~ScopedPoolAllocatorOptions() {
+    glslang::SetThreadPoolAllocator(nullptr);
+    glslang::SetThreadPoolAllocatorOptions(previous_options_);
+  }
+
+ private:
+  const glslang::TPoolAllocatorOptions previous_options_;
+};
+
+// Removes the preamble from preprocessed text as it streams by, with the same
+// result as Compiler::CleanupPreamble.  Lines are only collected until the
+// #version line of the main file (or the first other line after the preamble)
+// has gone by; everything after it is forwarded as it arrives.
+//
+// Like CleanupPreamble, the #extension line of the preamble and a #line
+// directive for the main file are kept if the shader #included a file.  That
+// is only known once an #include has been processed, or preprocessing has
+// finished, so until then the text after the preamble is held back, up to
+// kMaxHeldSize bytes.  Past that, they are kept as if a file was included,
+// so that memory stays bounded.
+class PreambleStripper : public glslang::TShader::PreprocessedTextSink {
+ public:
+  // The most text held back while it is unknown whether a file is included.
+  static const size_t kMaxHeldSize = 256 * 1024;
+
+  // may_include is false if the shader cannot #include files, which saves
+  // holding back text; included tells whether a file has been #included so
+  // far.  is_for_next_line tells, given the #version line of the main file or
+  // an empty string, whether #line sets the next line's number.
+  PreambleStripper(
+      string_piece pound_extension, string_piece error_tag, bool may_include,
+      std::function<bool()> included,
+      std::function<bool(const std::string& version_line)> is_for_next_line,
+      const std::function<void(const string_piece&)>& text_sink)
+      : pound_extension_(pound_extension),
+        error_tag_(error_tag),
+        may_include_(may_include),
+        included_(std::move(included)),
+        is_for_next_line_(std::move(is_for_next_line)),
+        text_sink_(text_sink) {}
+
+  void write(const char* text, size_t length) override {
+    const char* const end = text + length;
+    while (text != end && (state_ == State::kPreamble ||
+                           state_ == State::kBeforeVersion)) {
+      const char* newline =
+          static_cast<const char*>(memchr(text, '\n', end - text));
+      const char* line_end = newline ? newline + 1 : end;
+      line_.append(text, line_end);
+      text = line_end;
+      if (newline) {
+        HandleLine(line_);
+        line_.clear();
+      }
+    }
+    if (state_ == State::kUndecided) {
+      held_body_.append(text, end);
+      if (included_() || held_body_.size() > kMaxHeldSize) {
+        Decide(/* with_include_header = */ true);
+      }
+      return;
+    }
+    if (text != end) text_sink_(string_piece(text, end));
+  }
+
+  // Handles the text left over once preprocessing is done.
+  void Finish() {
+    if (state_ == State::kUndecided) Decide(included_());
+    if (!line_.empty()) HandleLine(line_);
+    line_.clear();
+    if (state_ == State::kBeforeVersion) EmitIncludeHeader("");
+    if (state_ == State::kPreamble) Emit(held_);
+  }
+
+ private:
+  enum class State {
+    kPreamble,       // before the #extension line ending the preamble
+    kUndecided,      // after it, holding text until it is known whether the
+                     // shader #includes files
+    kBeforeVersion,  // after it, before the first non-blank line
+    kBody,           // forwarding everything
+  };
+
+  // Handles the text held back while undecided, with or without the lines
+  // kept for a shader that #includes files.
+  void Decide(bool with_include_header) {
+    const std::string held_body = std::move(held_body_);
+    held_body_.clear();
+    if (with_include_header) {
+      state_ = State::kBeforeVersion;
+      write(held_body.data(), held_body.size());
+    } else {
+      Emit(held_);
+      state_ = State::kBody;
+      Emit(held_body);
+    }
+  }
+
+  void Emit(const string_piece& text) {
+    if (!text.empty()) text_sink_(text);
+  }
+
+  void HandleLine(const std::string& line) {
+    if (state_ == State::kPreamble) {
+      if (line == pound_extension_) {
+        if (may_include_) {
+          state_ = State::kUndecided;
+        } else {
+          Emit(held_);
+          state_ = State::kBody;
+        }
+      } else if (!string_piece(line).strip_whitespace().empty()) {
+        // Lines the preamble's macros left blank are dropped.
+        held_ += line;
+      }
+      return;
+    }
+
+    // State::kBeforeVersion
+    if (string_piece(line).strip_whitespace().empty()) {
+      ++blank_lines_;
+    } else if (string_piece(line).starts_with("#version")) {
+      // The #version line moves to the top, leaving a blank line behind.
+      Emit(line);
+      EmitIncludeHeader(line);
+      Emit("\n");
+    } else {
+      EmitIncludeHeader("");
+      Emit(line);
+    }
+  }
+
+  // Emits what goes between the #version line, if any, and the rest of the
+  // main file, and moves on to forwarding.
+  void EmitIncludeHeader(const std::string& version_line) {
+    Emit(held_);
+    Emit(pound_extension_);
+    Emit(GetLineDirective(is_for_next_line_(version_line), error_tag_));
+    Emit(std::string(blank_lines_, '\n'));
+    state_ = State::kBody;
+  }
+
+  const string_piece pound_extension_;
+  const string_piece error_tag_;
+  const bool may_include_;
+  const std::function<bool()> included_;
+  const std::function<bool(const std::string&)> is_for_next_line_;
+  const std::function<void(const string_piece&)>& text_sink_;
+
+  State state_ = State::kPreamble;
+  std::string line_;  // an incomplete line carried over between writes
+  std::string held_;  // non-blank lines of the preamble
+  std::string held_body_;  // text after the preamble, while undecided
+  size_t blank_lines_ = 0;
+};
+
+// Sets the tool field (the top 16-bits) in the generator word of a module
+// generated by glslang to 'Shaderc over Glslang'.
+void SetGeneratorWord(std::vector<uint32_t>* spirv) {
+  const uint32_t shaderc_generator_word = 13;  // From SPIR-V XML Registry
+  const uint32_t generator_word_index = 2;     // SPIR-V 2.3: Physical layout
+  assert(spirv->size() > generator_word_index);
+  (*spirv)[generator_word_index] = ((*spirv)[generator_word_index] & 0xffff) |
+                                   (shaderc_generator_word << 16);
+}
+
+// Returns the position of stage in a graphics pipeline, or -1 for stages
+// outside of one.  Stages that stand in for each other share a position.
+int PipelinePosition(EShLanguage stage) {
+  switch (stage) {
+    case EShLangVertex:
+    case EShLangTask:
+      return 0;
+    case EShLangTessControl:
+    case EShLangMesh:
+      return 1;
+    case EShLangTessEvaluation:
+      return 2;
+    case EShLangGeometry:
+      return 3;
+    case EShLangFragment:
+      return 4;
+    default:
+      return -1;
+  }
+}
+
+// Returns true if SPIRV-Tools can remove the dead output stores of stage.
+bool CanEliminateDeadOutputStores(EShLanguage stage) {
+  return stage == EShLangVertex || stage == EShLangTessControl ||
+         stage == EShLangTessEvaluation || stage == EShLangGeometry;
+}
+
+// Returns true if SPIRV-Tools can find the live inputs of stage.
+bool CanAnalyzeLiveInputs(EShLanguage stage) {
+  return stage == EShLangTessControl || stage == EShLangTessEvaluation ||
+         stage == EShLangGeometry || stage == EShLangFragment;
+}
+
+// Returns true if the module declares the TransformFeedback capability, in
+// which case its outputs are captured even when no later stage reads them.
+bool UsesTransformFeedback(const std::vector<uint32_t>& spirv) {
+  const uint32_t op_capability = 17;         // OpCapability
+  const uint32_t transform_feedback = 53;    // CapabilityTransformFeedback
+  const size_t first_instruction_index = 5;  // SPIR-V 2.3: Physical layout
+  // Capabilities come first in a module, so stop at the first other opcode.
+  for (size_t i = first_instruction_index; i < spirv.size();) {
+    const uint32_t word_count = spirv[i] >> 16;
+    if ((spirv[i] & 0xffff) != op_capability || word_count < 2) break;
+    if (i + 1 < spirv.size() && spirv[i + 1] == transform_feedback) {
+      return true;
+    }
+    i += word_count;
+  }
+  return false;
+}
+
 }  // anonymous namespace
 
 namespace shaderc_util {
 
-unsigned int GlslangInitializer::initialize_count_ = 0;
-std::mutex* GlslangInitializer::glslang_mutex_ = nullptr;
+std::atomic<unsigned int> GlslangInitializer::initialize_count_(0);
+std::atomic<bool> GlslangInitializer::keep_initialized_(false);
+
+std::mutex& GlslangInitializer::GetMutex() {
+  static std::mutex* glslang_mutex = new std::mutex();
+  return *glslang_mutex;
+}
 
 GlslangInitializer::GlslangInitializer() {
-  static std::mutex first_call_mutex;
-
-  // If this is the first call, glslang_mutex_ needs to be created, but in
-  // thread safe manner.
-  {
-    const std::lock_guard<std::mutex> first_call_lock(first_call_mutex);
-    if (glslang_mutex_ == nullptr) {
-      glslang_mutex_ = new std::mutex();
+  if (keep_initialized_.load(std::memory_order_acquire)) return;
+
+  // Fast path: glslang is already initialized, so just take a reference.  The
+  // count can only leave zero under the mutex below.
+  unsigned int count = initialize_count_.load(std::memory_order_relaxed);
+  while (count != 0) {
+    if (initialize_count_.compare_exchange_weak(count, count + 1,
+                                                std::memory_order_acquire,
+                                                std::memory_order_relaxed)) {
+      return;
     }
   }
 
-  const std::lock_guard<std::mutex> glslang_lock(*glslang_mutex_);
-
-  if (initialize_count_ == 0) {
+  const std::lock_guard<std::mutex> glslang_lock(GetMutex());
+  if (initialize_count_.load(std::memory_order_relaxed) == 0) {
     glslang::InitializeProcess();
   }
-
-  initialize_count_++;
+  initialize_count_.fetch_add(1, std::memory_order_release);
 }
 
 GlslangInitializer::~GlslangInitializer() {
-  const std::lock_guard<std::mutex> glslang_lock(*glslang_mutex_);
-
-  initialize_count_--;
+  // Once glslang is kept initialized, references taken before that point are
+  // simply never returned.
+  if (keep_initialized_.load(std::memory_order_acquire)) return;
+
+  // Fast path: this isn't the last reference.
+  unsigned int count = initialize_count_.load(std::memory_order_relaxed);
+  while (count > 1) {
+    if (initialize_count_.compare_exchange_weak(count, count - 1,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed)) {
+      return;
+    }
+  }
 
-  if (initialize_count_ == 0) {
+  // Possibly the last reference.  Holding the mutex while dropping it means
+  // any initializer that sees the count reach zero waits for finalization to
+  // finish before initializing again.
+  const std::lock_guard<std::mutex> glslang_lock(GetMutex());
+  if (initialize_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
     glslang::FinalizeProcess();
-    // There is no delete for glslang_mutex_ here, because we cannot guarantee
-    // there isn't a caller waiting for glslang_mutex_ in GlslangInitializer().
-    //
-    // This means that this class does leak one std::mutex worth of memory after
-    // the final instance is destroyed, but this allows us to defer allocating
-    // and constructing until we are sure we need to.
   }
 }
 
+void GlslangInitializer::KeepInitializedForProcessLifetime() {
+  if (keep_initialized_.load(std::memory_order_acquire)) return;
+
+  const std::lock_guard<std::mutex> glslang_lock(GetMutex());
+  if (keep_initialized_.load(std::memory_order_relaxed)) return;
+  if (initialize_count_.load(std::memory_order_relaxed) == 0) {
+    glslang::InitializeProcess();
+  }
+  // This reference is never dropped, so the count can not reach zero again.
+  initialize_count_.fetch_add(1, std::memory_order_relaxed);
+  keep_initialized_.store(true, std::memory_order_release);
+}
+
 void Compiler::SetLimit(Compiler::Limit limit, int value) {
   switch (limit) {
 #define RESOURCE(NAME, FIELD, CNAME) \
@@ -178,8 +502,395 @@ std::tuple<bool, std::vector<uint32_t>, size_t> Compiler::Compile(
                                     const string_piece& error_tag)>&
         stage_callback,
     CountingIncluder& includer, OutputType output_type,
+    std::ostream* error_stream, size_t* total_warnings, size_t* total_errors,
+    std::vector<PhaseTiming>* phase_timings,
+    glslang::TResourceLayout* resource_layout) const {
+  if (!cache_ || precompiled_preamble_ || resource_layout ||
+      output_type == OutputType::PreprocessedText ||
+      forced_shader_stage == EShLangCount) {
+    return CompileUncached(input_source_string, forced_shader_stage, error_tag,
+                           entry_point_name, stage_callback, includer,
+                           output_type, error_stream, total_warnings,
+                           total_errors, phase_timings, resource_layout);
+  }
+
+  PhaseTimer timer(phase_timings);
+
+  const std::string cache_key =
+      GetCacheKey(input_source_string, forced_shader_stage, error_tag,
+                  entry_point_name, output_type);
+  CompilationCache::Entry entry;
+  if (cache_->Lookup(cache_key, includer, &entry)) {
+    timer.Record("cache-lookup");
+    *error_stream << entry.messages;
+    *total_warnings += static_cast<size_t>(entry.num_warnings);
+    return std::make_tuple(
+        true, std::move(entry.output_data),
+        static_cast<size_t>(entry.output_data_size_in_bytes));
+  }
+
+  // Capture the messages and warning count so that they can be replayed when
+  // the entry is hit later.
+  std::ostringstream messages;
+  size_t num_warnings = 0;
+  DependencyRecordingIncluder recording_includer(includer);
+  auto result_tuple = CompileUncached(
+      input_source_string, forced_shader_stage, error_tag, entry_point_name,
+      stage_callback, recording_includer, output_type, &messages,
+      &num_warnings, total_errors, phase_timings,
+      /* resource_layout = */ nullptr);
+  *error_stream << messages.str();
+  *total_warnings += num_warnings;
+
+  if (std::get<0>(result_tuple)) {
+    entry.dependencies = recording_includer.dependencies();
+    entry.output_data = std::get<1>(result_tuple);
+    entry.output_data_size_in_bytes = std::get<2>(result_tuple);
+    entry.messages = messages.str();
+    entry.num_warnings = num_warnings;
+    cache_->Insert(cache_key, entry);
+  }
+  return result_tuple;
+}
+
+bool Compiler::PreprocessToSink(
+    const string_piece& input_source_string, const std::string& error_tag,
+    CountingIncluder& includer,
+    const std::function<void(const string_piece& text)>& text_sink,
     std::ostream* error_stream, size_t* total_warnings,
     size_t* total_errors) const {
+  // Check target environment, as a full compilation would.
+  const auto target_client_info = GetGlslangClientInfo(
+      error_tag, target_env_, target_env_version_, target_spirv_version_,
+      target_spirv_version_is_forced_);
+  if (!target_client_info.error.empty()) {
+    *error_stream << target_client_info.error;
+    *total_warnings = 0;
+    *total_errors = 1;
+    return false;
+  }
+
+  const std::string macro_definitions =
+      shaderc_util::format(predefined_macros_, "#define ", " ", "\n");
+  const std::string pound_extension =
+      "#extension GL_GOOGLE_include_directive : enable\n";
+  const std::string preamble = macro_definitions + pound_extension;
+
+  // An #include directive needs the word, possibly split by a line
+  // continuation; it cannot come from a macro.
+  const bool may_include =
+      input_source_string.find("include") != string_piece::npos ||
+      input_source_string.find('\\') != string_piece::npos;
+  PreambleStripper stripper(
+      pound_extension, error_tag, may_include,
+      [&includer] { return includer.num_include_directives() > 0; },
+      [this](const std::string& version_line) {
+        int version;
+        EProfile profile;
+        std::tie(version, profile) = DeduceVersionProfile(version_line);
+        return LineDirectiveIsForNextLine(version, profile);
+      },
+      text_sink);
+
+  ScopedPoolAllocatorOptions pool_options(pool_allocator_options_);
+  bool success;
+  std::string glslang_errors;
+  std::tie(success, std::ignore, glslang_errors) = PreprocessShader(
+      error_tag, input_source_string, preamble, includer, &stripper);
+  stripper.Finish();
+
+  success &= PrintFilteredErrors(error_tag, error_stream, warnings_as_errors_,
+                                 /* suppress_warnings = */ true,
+                                 glslang_errors.c_str(), total_warnings,
+                                 total_errors);
+  return success;
+}
+
+bool Compiler::ScanDependencies(const string_piece& input_source_string,
+                                const std::string& error_tag,
+                                CountingIncluder& includer,
+                                glslang::TShader::Dependencies* dependencies,
+                                std::ostream* error_stream,
+                                size_t* total_warnings,
+                                size_t* total_errors) const {
+  const std::string preamble =
+      shaderc_util::format(predefined_macros_, "#define ", " ", "\n") +
+      "#extension GL_GOOGLE_include_directive : enable\n";
+
+  ScopedPoolAllocatorOptions pool_options(pool_allocator_options_);
+  bool success;
+  std::string glslang_errors;
+  std::tie(success, std::ignore, glslang_errors) =
+      PreprocessShader(error_tag, input_source_string, preamble, includer,
+                       /* output_sink = */ nullptr, dependencies);
+
+  success &= PrintFilteredErrors(error_tag, error_stream, warnings_as_errors_,
+                                 /* suppress_warnings = */ true,
+                                 glslang_errors.c_str(), total_warnings,
+                                 total_errors);
+  return success;
+}
+
+bool Compiler::CompilePipeline(
+    const std::vector<PipelineStage>& stages, ThreadPool* thread_pool,
+    std::vector<PipelineStageResult>* results,
+    glslang::TResourceLayout* resource_layout) const {
+  results->assign(stages.size(), PipelineStageResult());
+
+  bool success = !stages.empty();
+  for (size_t i = 0; i < stages.size(); ++i) {
+    for (size_t j = 0; j < i; ++j) {
+      if (stages[j].stage == stages[i].stage) {
+        (*results)[i].messages =
+            stages[i].error_tag +
+            ": error: the pipeline already has a shader of this stage\n";
+        (*results)[i].num_errors = 1;
+        success = false;
+      }
+    }
+  }
+  if (!success) return false;
+
+  const std::string preamble =
+      shaderc_util::format(predefined_macros_, "#define ", " ", "\n") +
+      "#extension GL_GOOGLE_include_directive : enable\n";
+  const EShMessages rules =
+      GetMessageRules(target_env_, source_language_, hlsl_offsets_,
+                      hlsl_16bit_types_enabled_, generate_debug_info_);
+
+  // Each stage is parsed where its task runs, but linked, and destroyed, on
+  // this thread.  Nothing of a shader's pool is touched by two threads at
+  // once, since the program is only linked after every parse has finished.
+  std::vector<std::unique_ptr<glslang::TShader>> shaders(stages.size());
+  auto parse_stage = [&](size_t i) {
+    const PipelineStage& stage = stages[i];
+    PipelineStageResult& result = (*results)[i];
+    std::ostringstream errors;
+    ScopedPoolAllocatorOptions pool_options(pool_allocator_options_);
+
+    const auto target_client_info = GetGlslangClientInfo(
+        stage.error_tag, target_env_, target_env_version_,
+        target_spirv_version_, target_spirv_version_is_forced_);
+    if (!target_client_info.error.empty()) {
+      result.messages = target_client_info.error;
+      result.num_errors = 1;
+      return;
+    }
+
+    auto shader = std::make_unique<glslang::TShader>(stage.stage);
+    const char* shader_strings = stage.source.data();
+    const int shader_lengths = static_cast<int>(stage.source.size());
+    const char* string_names = stage.error_tag.c_str();
+    shader->setStringsWithLengthsAndNames(&shader_strings, &shader_lengths,
+                                          &string_names, 1);
+    shader->setPreamble(preamble.c_str());
+    shader->setPrecompiledPreamble(precompiled_preamble_.get());
+    ConfigureShader(shader.get(), stage.stage, stage.entry_point_name,
+                    target_client_info);
+
+    bool parsed = shader->parse(&limits_, default_version_, default_profile_,
+                                force_version_profile_, kNotForwardCompatible,
+                                rules, *stage.includer);
+    parsed &= PrintFilteredErrors(stage.error_tag, &errors, warnings_as_errors_,
+                                  suppress_warnings_, shader->getInfoLog(),
+                                  &result.num_warnings, &result.num_errors);
+    result.messages = errors.str();
+    if (parsed) shaders[i] = std::move(shader);
+  };
+  if (thread_pool) {
+    thread_pool->ParallelFor(stages.size(), parse_stage);
+  } else {
+    for (size_t i = 0; i < stages.size(); ++i) parse_stage(i);
+  }
+  for (const auto& shader : shaders) success &= shader != nullptr;
+  if (!success) return false;
+
+  ScopedPoolAllocatorOptions pool_options(pool_allocator_options_);
+  glslang::TProgram program;
+  for (const auto& shader : shaders) program.addShader(shader.get());
+  program.setCaptureResourceLayout(resource_layout != nullptr);
+  success = program.link(EShMsgDefault) && program.mapIO();
+  // The link messages concern the whole pipeline, so every stage gets them.
+  for (size_t i = 0; i < stages.size(); ++i) {
+    PipelineStageResult& result = (*results)[i];
+    std::ostringstream errors;
+    success &= PrintFilteredErrors(
+        stages[i].error_tag, &errors, warnings_as_errors_, suppress_warnings_,
+        program.getInfoLog(), &result.num_warnings, &result.num_errors);
+    result.messages += errors.str();
+  }
+  if (!success) return false;
+  if (resource_layout) *resource_layout = program.getResourceLayout();
+
+  glslang::SpvOptions options;
+  options.generateDebugInfo = generate_debug_info_;
+  options.disableOptimizer = true;
+  options.optimizeSize = false;
+  for (size_t i = 0; i < stages.size(); ++i) {
+    std::vector<uint32_t>& spirv = (*results)[i].spirv;
+    glslang::GlslangToSpv(*program.getIntermediate(stages[i].stage), spirv,
+                          &options);
+    SetGeneratorWord(&spirv);
+  }
+
+  const std::vector<PassId> opt_passes = GetOptimizationPasses();
+  if (!opt_passes.empty()) {
+    // Across stages, only optimize as far as the optimization level asks.
+    const bool across_stages =
+        std::any_of(opt_passes.begin(), opt_passes.end(), [](PassId pass) {
+          return pass == PassId::kPerformancePasses ||
+                 pass == PassId::kSizePasses;
+        });
+
+    // A stage can only lose the outputs its successor does not read once the
+    // successor has been optimized, so go through the pipeline backwards.
+    std::vector<size_t> order(stages.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&stages](size_t a, size_t b) {
+      return PipelinePosition(stages[a].stage) >
+             PipelinePosition(stages[b].stage);
+    });
+
+    std::vector<StageInterface> interfaces(stages.size());
+    for (size_t n = 0; n < order.size(); ++n) {
+      const size_t i = order[n];
+      const EShLanguage stage = stages[i].stage;
+      std::vector<PassId> passes = opt_passes;
+      if (across_stages && n > 0) {
+        const size_t next = order[n - 1];
+        const EShLanguage next_stage = stages[next].stage;
+        if (PipelinePosition(stage) >= 0 &&
+            PipelinePosition(stage) < PipelinePosition(next_stage) &&
+            CanEliminateDeadOutputStores(stage) &&
+            CanAnalyzeLiveInputs(next_stage) &&
+            !UsesTransformFeedback((*results)[i].spirv)) {
+          interfaces[i].next_stage_live_locations =
+              interfaces[next].live_input_locations;
+          interfaces[i].next_stage_live_builtins =
+              interfaces[next].live_input_builtins;
+          passes.push_back(PassId::kEliminateDeadOutputStores);
+        }
+      }
+      if (across_stages && CanAnalyzeLiveInputs(stage)) {
+        passes.push_back(PassId::kAnalyzeLiveInputs);
+      }
+
+      spvtools::OptimizerOptions opt_options;
+      opt_options.set_preserve_bindings(preserve_bindings_);
+      std::string opt_errors;
+      if (!SpirvToolsOptimize(target_env_, target_env_version_, passes,
+                              opt_options, &(*results)[i].spirv, &opt_errors,
+                              /* pass_timings = */ nullptr, &interfaces[i])) {
+        (*results)[i].messages +=
+            "shaderc: internal error: compilation succeeded but failed to "
+            "optimize: " +
+            opt_errors + "\n";
+        success = false;
+        break;
+      }
+    }
+  }
+
+  for (PipelineStageResult& result : *results) {
+    result.succeeded = success;
+    if (!success) result.spirv.clear();
+  }
+  return success;
+}
+
+std::string Compiler::GetCacheKey(const string_piece& input_source_string,
+                                  EShLanguage forced_shader_stage,
+                                  const std::string& error_tag,
+                                  const char* entry_point_name,
+                                  OutputType output_type) const {
+  CacheKeyHasher hasher;
+
+  // Tie the key to the compiler versions, so that persisted entries are not
+  // reused after an upgrade.
+  hasher.Add("shaderc compilation cache");
+  const glslang::Version glslang_version = glslang::GetVersion();
+  hasher.AddValue(glslang_version.major);
+  hasher.AddValue(glslang_version.minor);
+  hasher.AddValue(glslang_version.patch);
+  hasher.Add(glslang_version.flavor);
+  hasher.Add(spvSoftwareVersionDetailsString());
+
+  hasher.Add(input_source_string);
+  hasher.AddValue(forced_shader_stage);
+  hasher.Add(error_tag);
+  hasher.Add(entry_point_name);
+  hasher.AddValue(output_type);
+
+  // Sort the macros, since the iteration order of the dictionary is
+  // unspecified.
+  std::vector<std::pair<std::string, std::string>> macros(
+      predefined_macros_.begin(), predefined_macros_.end());
+  std::sort(macros.begin(), macros.end());
+  hasher.AddValue(macros.size());
+  for (const auto& macro : macros) {
+    hasher.Add(macro.first);
+    hasher.Add(macro.second);
+  }
+
+  hasher.AddValue(default_version_);
+  hasher.AddValue(default_profile_);
+  hasher.AddValue(force_version_profile_);
+  hasher.AddValue(warnings_as_errors_);
+  hasher.AddValue(suppress_warnings_);
+  hasher.AddValue(generate_debug_info_);
+  hasher.AddValue(enabled_opt_passes_.size());
+  for (const PassId pass : enabled_opt_passes_) hasher.AddValue(pass);
+  hasher.AddValue(target_env_);
+  hasher.AddValue(target_env_version_);
+  hasher.AddValue(target_spirv_version_);
+  hasher.AddValue(target_spirv_version_is_forced_);
+  hasher.AddValue(source_language_);
+#define RESOURCE(NAME, FIELD, CNAME) hasher.AddValue(limits_.FIELD);
+#include "libshaderc_util/resources.inc"
+#undef RESOURCE
+  hasher.AddValue(limits_.limits.nonInductiveForLoops);
+  hasher.AddValue(limits_.limits.whileLoops);
+  hasher.AddValue(limits_.limits.doWhileLoops);
+  hasher.AddValue(limits_.limits.generalUniformIndexing);
+  hasher.AddValue(limits_.limits.generalAttributeMatrixVectorIndexing);
+  hasher.AddValue(limits_.limits.generalVaryingIndexing);
+  hasher.AddValue(limits_.limits.generalSamplerIndexing);
+  hasher.AddValue(limits_.limits.generalVariableIndexing);
+  hasher.AddValue(limits_.limits.generalConstantMatrixVectorIndexing);
+  hasher.AddValue(auto_bind_uniforms_);
+  hasher.AddValue(auto_combined_image_sampler_);
+  hasher.AddValue(auto_binding_base_);
+  hasher.AddValue(auto_map_locations_);
+  hasher.AddValue(preserve_bindings_);
+  hasher.AddValue(hlsl_iomap_);
+  hasher.AddValue(hlsl_offsets_);
+  hasher.AddValue(hlsl_legalization_enabled_);
+  hasher.AddValue(hlsl_functionality1_enabled_);
+  hasher.AddValue(hlsl_16bit_types_enabled_);
+  hasher.AddValue(vulkan_rules_relaxed_);
+  hasher.AddValue(invert_y_enabled_);
+  hasher.AddValue(nan_clamp_);
+  for (const auto& bindings : hlsl_explicit_bindings_) {
+    hasher.AddValue(bindings.size());
+    for (const auto& binding : bindings) hasher.Add(binding);
+  }
+
+  return hasher.Digest();
+}
+
+std::tuple<bool, std::vector<uint32_t>, size_t> Compiler::CompileUncached(
+    const string_piece& input_source_string, EShLanguage forced_shader_stage,
+    const std::string& error_tag, const char* entry_point_name,
+    const std::function<EShLanguage(std::ostream* error_stream,
+                                    const string_piece& error_tag)>&
+        stage_callback,
+    CountingIncluder& includer, OutputType output_type,
+    std::ostream* error_stream, size_t* total_warnings, size_t* total_errors,
+    std::vector<PhaseTiming>* phase_timings,
+    glslang::TResourceLayout* resource_layout) const {
+  PhaseTimer timer(phase_timings);
+  ScopedPoolAllocatorOptions pool_options(pool_allocator_options_);
+
   // Compilation results to be returned:
   // Initialize the result tuple as a failed compilation. In error cases, we
   // should return result_tuple directly without setting its members.
@@ -210,6 +921,19 @@ std::tuple<bool, std::vector<uint32_t>, size_t> Compiler::Compile(
   const std::string preamble = macro_definitions + pound_extension;
 
   std::string preprocessed_shader;
+  // If the stage has to be deduced, the shader is parsed from the
+  // preprocessed text rather than preprocessed a second time.  That text
+  // keeps the line structure and #line directives of the source, with macros
+  // expanded and files included, so it gives the same module.  Debug info
+  // records the source text, though, and the text does not always spell a
+  // token as it was scanned (see TShader::isPreprocessedTextExact()), so in
+  // those cases the original source is parsed.
+  bool parse_preprocessed_shader =
+      output_type != OutputType::PreprocessedText &&
+      used_shader_stage == EShLangCount && !generate_debug_info_;
+  // The messages of preprocessing, for the warnings the parse of the
+  // preprocessed text cannot repeat.
+  std::string preprocessing_log;
 
   // If only preprocessing, we definitely need to preprocess. Otherwise, if
   // we don't know the stage until now, we need the preprocessed shader to
@@ -218,14 +942,22 @@ std::tuple<bool, std::vector<uint32_t>, size_t> Compiler::Compile(
       used_shader_stage == EShLangCount) {
     bool success;
     std::string glslang_errors;
-    std::tie(success, preprocessed_shader, glslang_errors) =
-        PreprocessShader(error_tag, input_source_string, preamble, includer);
+    bool text_is_exact = false;
+    std::tie(success, preprocessed_shader, glslang_errors) = PreprocessShader(
+        error_tag, input_source_string, preamble, includer,
+        /* output_sink = */ nullptr, /* dependencies = */ nullptr,
+        &text_is_exact);
+    timer.Record("preprocess");
+    parse_preprocessed_shader &= text_is_exact;
 
     success &= PrintFilteredErrors(error_tag, error_stream, warnings_as_errors_,
                                    /* suppress_warnings = */ true,
                                    glslang_errors.c_str(), total_warnings,
                                    total_errors);
     if (!success) return result_tuple;
+    if (parse_preprocessed_shader) {
+      preprocessing_log = std::move(glslang_errors);
+    }
     // Because of the behavior change of the #line directive, the #line
     // directive introducing each file's content must use the syntax for the
     // specified version. So we need to probe this shader's version and
@@ -247,8 +979,8 @@ std::tuple<bool, std::vector<uint32_t>, size_t> Compiler::Compile(
       return result_tuple;
     } else if (used_shader_stage == EShLangCount) {
       std::string errors;
-      std::tie(used_shader_stage, errors) =
-          GetShaderStageFromSourceCode(error_tag, preprocessed_shader);
+      std::tie(used_shader_stage, errors) = GetShaderStageFromSourceCode(
+          error_tag, preprocessed_shader, is_for_next_line);
       if (!errors.empty()) {
         *error_stream << errors;
         return result_tuple;
@@ -264,57 +996,23 @@ std::tuple<bool, std::vector<uint32_t>, size_t> Compiler::Compile(
 
   // Parsing requires its own Glslang symbol tables.
   glslang::TShader shader(used_shader_stage);
-  const char* shader_strings = input_source_string.data();
-  const int shader_lengths = static_cast<int>(input_source_string.size());
+  const string_piece shader_source = parse_preprocessed_shader
+                                         ? string_piece(preprocessed_shader)
+                                         : input_source_string;
+  const char* shader_strings = shader_source.data();
+  const int shader_lengths = static_cast<int>(shader_source.size());
   const char* string_names = error_tag.c_str();
   shader.setStringsWithLengthsAndNames(&shader_strings, &shader_lengths,
                                        &string_names, 1);
-  shader.setPreamble(preamble.c_str());
-  shader.setEntryPoint(entry_point_name);
-  shader.setAutoMapBindings(auto_bind_uniforms_);
-  if (auto_combined_image_sampler_) {
-    shader.setTextureSamplerTransformMode(
-        EShTexSampTransUpgradeTextureRemoveSampler);
-  }
-  shader.setAutoMapLocations(auto_map_locations_);
-  const auto& bases = auto_binding_base_[static_cast<int>(used_shader_stage)];
-  shader.setShiftImageBinding(bases[static_cast<int>(UniformKind::Image)]);
-  shader.setShiftSamplerBinding(bases[static_cast<int>(UniformKind::Sampler)]);
-  shader.setShiftTextureBinding(bases[static_cast<int>(UniformKind::Texture)]);
-  shader.setShiftUboBinding(bases[static_cast<int>(UniformKind::Buffer)]);
-  shader.setShiftSsboBinding(
-      bases[static_cast<int>(UniformKind::StorageBuffer)]);
-  shader.setShiftUavBinding(
-      bases[static_cast<int>(UniformKind::UnorderedAccessView)]);
-  shader.setHlslIoMapping(hlsl_iomap_);
-  shader.setResourceSetBinding(
-      hlsl_explicit_bindings_[static_cast<int>(used_shader_stage)]);
-  shader.setEnvClient(target_client_info.client,
-                      target_client_info.client_version);
-  shader.setEnvTarget(target_client_info.target_language,
-                      target_client_info.target_language_version);
-  if (hlsl_functionality1_enabled_) {
-    shader.setEnvTargetHlslFunctionality1();
-  }
-  if (vulkan_rules_relaxed_) {
-    glslang::EShSource language = glslang::EShSourceNone;
-    switch (source_language_) {
-      case SourceLanguage::GLSL:
-        language = glslang::EShSourceGlsl;
-        break;
-      case SourceLanguage::HLSL:
-        language = glslang::EShSourceHlsl;
-        break;
-    }
-    // This option will only be used if the Vulkan client is used.
-    // If new versions of GL_KHR_vulkan_glsl come out, it would make sense to
-    // let callers specify which version to use. For now, just use 100.
-    shader.setEnvInput(language, used_shader_stage, glslang::EShClientVulkan,
-                       100);
-    shader.setEnvInputVulkanRulesRelaxed();
+  if (parse_preprocessed_shader) {
+    // Macros are already expanded; the extension is still noted in the module.
+    shader.setPreamble(pound_extension.c_str());
+  } else {
+    shader.setPreamble(preamble.c_str());
+    shader.setPrecompiledPreamble(precompiled_preamble_.get());
   }
-  shader.setInvertY(invert_y_enabled_);
-  shader.setNanMinMaxClamp(nan_clamp_);
+  ConfigureShader(&shader, used_shader_stage, entry_point_name,
+                  target_client_info);
 
   const EShMessages rules =
       GetMessageRules(target_env_, source_language_, hlsl_offsets_,
@@ -323,19 +1021,32 @@ std::tuple<bool, std::vector<uint32_t>, size_t> Compiler::Compile(
   bool success = shader.parse(&limits_, default_version_, default_profile_,
                               force_version_profile_, kNotForwardCompatible,
                               rules, includer);
+  // parse() makes the shader's own, initially empty, pool the current one.
+  timer.Record("parse", ThreadPoolBytes());
 
+  const std::string parse_log =
+      AddPreprocessingWarnings(preprocessing_log, shader.getInfoLog());
   success &= PrintFilteredErrors(error_tag, error_stream, warnings_as_errors_,
-                                 suppress_warnings_, shader.getInfoLog(),
+                                 suppress_warnings_, parse_log.c_str(),
                                  total_warnings, total_errors);
   if (!success) return result_tuple;
 
   glslang::TProgram program;
   program.addShader(&shader);
-  success = program.link(EShMsgDefault) && program.mapIO();
+  program.setCaptureResourceLayout(resource_layout != nullptr);
+  // Likewise for link() and the program's pool.
+  success = program.link(EShMsgDefault);
+  const size_t linked_pool_bytes = ThreadPoolBytes();
+  timer.Record("link", linked_pool_bytes);
+  if (success) {
+    success = program.mapIO();
+    timer.Record("map-io", ThreadPoolBytes() - linked_pool_bytes);
+  }
   success &= PrintFilteredErrors(error_tag, error_stream, warnings_as_errors_,
                                  suppress_warnings_, program.getInfoLog(),
                                  total_warnings, total_errors);
   if (!success) return result_tuple;
+  if (resource_layout) *resource_layout = program.getResourceLayout();
 
   // 'spirv' is an alias for the compilation_output_data. This alias is added
   // to serve as an input for the call to DissassemblyBinary.
@@ -345,35 +1056,25 @@ std::tuple<bool, std::vector<uint32_t>, size_t> Compiler::Compile(
   options.disableOptimizer = true;
   options.optimizeSize = false;
   // Note the call to GlslangToSpv also populates compilation_output_data.
+  const size_t mapped_pool_bytes = ThreadPoolBytes();
   glslang::GlslangToSpv(*program.getIntermediate(used_shader_stage), spirv,
                         &options);
+  timer.Record("generate-spirv", ThreadPoolBytes() - mapped_pool_bytes);
 
-  // Set the tool field (the top 16-bits) in the generator word to
-  // 'Shaderc over Glslang'.
-  const uint32_t shaderc_generator_word = 13;  // From SPIR-V XML Registry
-  const uint32_t generator_word_index = 2;     // SPIR-V 2.3: Physical layout
-  assert(spirv.size() > generator_word_index);
-  spirv[generator_word_index] =
-      (spirv[generator_word_index] & 0xffff) | (shaderc_generator_word << 16);
-
-  std::vector<PassId> opt_passes;
-
-  if (hlsl_legalization_enabled_ && source_language_ == SourceLanguage::HLSL) {
-    // If from HLSL, run this passes to "legalize" the SPIR-V for Vulkan
-    // eg. forward and remove memory writes of opaque types.
-    opt_passes.push_back(PassId::kLegalizationPasses);
-  }
-
-  opt_passes.insert(opt_passes.end(), enabled_opt_passes_.begin(),
-                    enabled_opt_passes_.end());
+  SetGeneratorWord(&spirv);
 
+  const std::vector<PassId> opt_passes = GetOptimizationPasses();
   if (!opt_passes.empty()) {
     spvtools::OptimizerOptions opt_options;
     opt_options.set_preserve_bindings(preserve_bindings_);
 
     std::string opt_errors;
-    if (!SpirvToolsOptimize(target_env_, target_env_version_, opt_passes,
-                            opt_options, &spirv, &opt_errors)) {
+    const bool optimized = SpirvToolsOptimize(
+        target_env_, target_env_version_, opt_passes, opt_options, &spirv,
+        &opt_errors, timer.pass_timings());
+    timer.Record("optimize");
+    timer.RecordPasses("optimize");
+    if (!optimized) {
       *error_stream << "shaderc: internal error: compilation succeeded but "
                        "failed to optimize: "
                     << opt_errors << "\n";
@@ -383,8 +1084,10 @@ std::tuple<bool, std::vector<uint32_t>, size_t> Compiler::Compile(
 
   if (output_type == OutputType::SpirvAssemblyText) {
     std::string text_or_error;
-    if (!SpirvToolsDisassemble(target_env_, target_env_version_, spirv,
-                               &text_or_error)) {
+    const bool disassembled = SpirvToolsDisassemble(
+        target_env_, target_env_version_, spirv, &text_or_error);
+    timer.Record("disassemble");
+    if (!disassembled) {
       *error_stream << "shaderc: internal error: compilation succeeded but "
                        "failed to disassemble: "
                     << text_or_error << "\n";
@@ -402,6 +1105,69 @@ std::tuple<bool, std::vector<uint32_t>, size_t> Compiler::Compile(
   }
 }
 
+void Compiler::ConfigureShader(
+    glslang::TShader* shader, EShLanguage stage, const char* entry_point_name,
+    const GlslangClientInfo& target_client_info) const {
+  shader->setEntryPoint(entry_point_name);
+  shader->setAutoMapBindings(auto_bind_uniforms_);
+  if (auto_combined_image_sampler_) {
+    shader->setTextureSamplerTransformMode(
+        EShTexSampTransUpgradeTextureRemoveSampler);
+  }
+  shader->setAutoMapLocations(auto_map_locations_);
+  const auto& bases = auto_binding_base_[static_cast<int>(stage)];
+  shader->setShiftImageBinding(bases[static_cast<int>(UniformKind::Image)]);
+  shader->setShiftSamplerBinding(bases[static_cast<int>(UniformKind::Sampler)]);
+  shader->setShiftTextureBinding(bases[static_cast<int>(UniformKind::Texture)]);
+  shader->setShiftUboBinding(bases[static_cast<int>(UniformKind::Buffer)]);
+  shader->setShiftSsboBinding(
+      bases[static_cast<int>(UniformKind::StorageBuffer)]);
+  shader->setShiftUavBinding(
+      bases[static_cast<int>(UniformKind::UnorderedAccessView)]);
+  shader->setHlslIoMapping(hlsl_iomap_);
+  shader->setResourceSetBinding(
+      hlsl_explicit_bindings_[static_cast<int>(stage)]);
+  shader->setEnvClient(target_client_info.client,
+                       target_client_info.client_version);
+  shader->setEnvTarget(target_client_info.target_language,
+                       target_client_info.target_language_version);
+  if (hlsl_functionality1_enabled_) {
+    shader->setEnvTargetHlslFunctionality1();
+  }
+  if (vulkan_rules_relaxed_) {
+    glslang::EShSource language = glslang::EShSourceNone;
+    switch (source_language_) {
+      case SourceLanguage::GLSL:
+        language = glslang::EShSourceGlsl;
+        break;
+      case SourceLanguage::HLSL:
+        language = glslang::EShSourceHlsl;
+        break;
+    }
+    // This option will only be used if the Vulkan client is used.
+    // If new versions of GL_KHR_vulkan_glsl come out, it would make sense to
+    // let callers specify which version to use. For now, just use 100.
+    shader->setEnvInput(language, stage, glslang::EShClientVulkan, 100);
+    shader->setEnvInputVulkanRulesRelaxed();
+  }
+  shader->setInvertY(invert_y_enabled_);
+  shader->setNanMinMaxClamp(nan_clamp_);
+}
+
+std::vector<PassId> Compiler::GetOptimizationPasses() const {
+  std::vector<PassId> opt_passes;
+
+  if (hlsl_legalization_enabled_ && source_language_ == SourceLanguage::HLSL) {
+    // If from HLSL, run this passes to "legalize" the SPIR-V for Vulkan
+    // eg. forward and remove memory writes of opaque types.
+    opt_passes.push_back(PassId::kLegalizationPasses);
+  }
+
+  opt_passes.insert(opt_passes.end(), enabled_opt_passes_.begin(),
+                    enabled_opt_passes_.end());
+  return opt_passes;
+}
+
 void Compiler::AddMacroDefinition(const char* macro, size_t macro_length,
                                   const char* definition,
                                   size_t definition_length) {
@@ -487,7 +1253,9 @@ void Compiler::SetSuppressWarnings() { suppress_warnings_ = true; }
 
 std::tuple<bool, std::string, std::string> Compiler::PreprocessShader(
     const std::string& error_tag, const string_piece& shader_source,
-    const string_piece& shader_preamble, CountingIncluder& includer) const {
+    const string_piece& shader_preamble, CountingIncluder& includer,
+    glslang::TShader::PreprocessedTextSink* output_sink,
+    glslang::TShader::Dependencies* dependencies, bool* text_is_exact) const {
   // The stage does not matter for preprocessing.
   glslang::TShader shader(EShLangVertex);
   const char* shader_strings = shader_source.data();
@@ -496,6 +1264,7 @@ std::tuple<bool, std::string, std::string> Compiler::PreprocessShader(
   shader.setStringsWithLengthsAndNames(&shader_strings, &shader_lengths,
                                        &string_names, 1);
   shader.setPreamble(shader_preamble.data());
+  shader.setPrecompiledPreamble(precompiled_preamble_.get());
   auto target_client_info = GetGlslangClientInfo(
       error_tag, target_env_, target_env_version_, target_spirv_version_,
       target_spirv_version_is_forced_);
@@ -519,9 +1288,21 @@ std::tuple<bool, std::string, std::string> Compiler::PreprocessShader(
                       hlsl_16bit_types_enabled_, false));
 
   std::string preprocessed_shader;
-  const bool success = shader.preprocess(
-      &limits_, default_version_, default_profile_, force_version_profile_,
-      kNotForwardCompatible, rules, &preprocessed_shader, includer);
+  bool success;
+  if (dependencies) {
+    success = shader.scanDependencies(
+        &limits_, default_version_, default_profile_, force_version_profile_,
+        kNotForwardCompatible, rules, includer, *dependencies);
+  } else if (output_sink) {
+    success = shader.preprocess(&limits_, default_version_, default_profile_,
+                                force_version_profile_, kNotForwardCompatible,
+                                rules, *output_sink, includer);
+  } else {
+    success = shader.preprocess(&limits_, default_version_, default_profile_,
+                                force_version_profile_, kNotForwardCompatible,
+                                rules, &preprocessed_shader, includer);
+  }
+  if (text_is_exact) *text_is_exact = shader.isPreprocessedTextExact();
 
   if (success) {
     return std::make_tuple(true, preprocessed_shader, shader.getInfoLog());
@@ -597,15 +1378,11 @@ std::string Compiler::CleanupPreamble(const string_piece& preprocessed_shader,
 }
 
 std::pair<EShLanguage, std::string> Compiler::GetShaderStageFromSourceCode(
-    string_piece filename, const std::string& preprocessed_shader) const {
+    string_piece filename, const std::string& preprocessed_shader,
+    bool is_for_next_line) const {
   const string_piece kPragmaShaderStageDirective = "#pragma shader_stage";
   const string_piece kLineDirective = "#line";
 
-  int version;
-  EProfile profile;
-  std::tie(version, profile) = DeduceVersionProfile(preprocessed_shader);
-  const bool is_for_next_line = LineDirectiveIsForNextLine(version, profile);
-
   std::vector<string_piece> lines =
       string_piece(preprocessed_shader).get_fields('\n');
   // The filename, logical line number (which starts from 1 and is sensitive to
@@ -0,0 +1,102 @@
+// Copyright 2026 The Shaderc Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libshaderc_util/include_file_cache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+using IncludeResult = glslang::TShader::Includer::IncludeResult;
+
+// Returns an include result that reports the given error.  message must have
+// static storage duration.
+IncludeResult* MakeErrorIncludeResult(const char* message) {
+  return new IncludeResult{"", message, strlen(message), nullptr};
+}
+
+}  // anonymous namespace
+
+namespace shaderc_util {
+
+IncludeFileCache::Contents IncludeFileCache::Read(const std::string& path) {
+  std::error_code error;
+  const auto mtime = std::filesystem::last_write_time(path, error);
+  if (error) return nullptr;
+  const auto size = std::filesystem::file_size(path, error);
+  if (error) return nullptr;
+
+  std::shared_ptr<Slot> slot;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = slots_[path];
+    if (!entry) entry = std::make_shared<Slot>();
+    slot = entry;
+  }
+
+  std::lock_guard<std::mutex> lock(slot->mutex);
+  if (slot->contents && slot->mtime == mtime && slot->size == size) {
+    return slot->contents;
+  }
+
+  std::ifstream stream(path, std::ios_base::binary);
+  if (!stream) return nullptr;
+  std::string data;
+  data.reserve(static_cast<size_t>(size));
+  data.assign(std::istreambuf_iterator<char>(stream),
+              std::istreambuf_iterator<char>());
+  if (stream.bad()) return nullptr;
+
+  slot->contents = std::make_shared<const std::string>(std::move(data));
+  slot->mtime = mtime;
+  slot->size = size;
+  return slot->contents;
+}
+
+void IncludeFileCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  slots_.clear();
+}
+
+IncludeResult* CachingFileIncluder::include_delegate(
+    const char* requested_source, const char* requesting_source,
+    IncludeType type, size_t) {
+  const std::string path =
+      (type == IncludeType::Local)
+          ? file_finder_.FindRelativeReadableFilepath(requesting_source,
+                                                      requested_source)
+          : file_finder_.FindReadableFilepath(requested_source);
+  if (path.empty()) {
+    return MakeErrorIncludeResult("Cannot find or open include file.");
+  }
+
+  IncludeFileCache::Contents contents = cache_->Read(path);
+  if (!contents) return MakeErrorIncludeResult("Cannot read file");
+
+  // The result keeps its own reference to the contents until it is released.
+  auto* holder = new IncludeFileCache::Contents(std::move(contents));
+  return new IncludeResult{path, (*holder)->data(), (*holder)->size(),
+                           holder};
+}
+
+void CachingFileIncluder::release_delegate(IncludeResult* result) {
+  if (result) {
+    delete static_cast<IncludeFileCache::Contents*>(result->userData);
+    delete result;
+  }
+}
+
+}  // namespace shaderc_util
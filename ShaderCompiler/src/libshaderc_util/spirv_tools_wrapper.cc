@@ -15,6 +15,7 @@
 #include "libshaderc_util/spirv_tools_wrapper.h"
 
 #include <algorithm>
+#include <cassert>
 #include <sstream>
 
 #include "spirv-tools/libspirv.hpp"
@@ -108,11 +109,13 @@ bool SpirvToolsAssemble(Compiler::TargetEnv env,
   return success;
 }
 
-bool SpirvToolsOptimize(Compiler::TargetEnv env,
-                        Compiler::TargetEnvVersion version,
-                        const std::vector<PassId>& enabled_passes,
-                        spvtools::OptimizerOptions& optimizer_options,
-                        std::vector<uint32_t>* binary, std::string* errors) {
+bool SpirvToolsOptimize(
+    Compiler::TargetEnv env, Compiler::TargetEnvVersion version,
+    const std::vector<PassId>& enabled_passes,
+    spvtools::OptimizerOptions& optimizer_options,
+    std::vector<uint32_t>* binary, std::string* errors,
+    std::vector<std::pair<std::string, double>>* pass_timings,
+    StageInterface* stage_interface) {
   errors->clear();
   if (enabled_passes.empty()) return true;
   if (std::all_of(
@@ -165,9 +168,23 @@ bool SpirvToolsOptimize(Compiler::TargetEnv env,
       case PassId::kCompactIds:
         optimizer.RegisterPass(spvtools::CreateCompactIdsPass());
         break;
+      case PassId::kEliminateDeadOutputStores:
+        assert(stage_interface);
+        optimizer.RegisterPass(spvtools::CreateEliminateDeadOutputStoresPass(
+            &stage_interface->next_stage_live_locations,
+            &stage_interface->next_stage_live_builtins));
+        optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass());
+        break;
+      case PassId::kAnalyzeLiveInputs:
+        assert(stage_interface);
+        optimizer.RegisterPass(spvtools::CreateAnalyzeLiveInputPass(
+            &stage_interface->live_input_locations,
+            &stage_interface->live_input_builtins));
+        break;
     }
   }
 
+  optimizer.SetPassTimings(pass_timings);
   if (!optimizer.Run(binary->data(), binary->size(), binary,
                      optimizer_options)) {
     *errors = oss.str();
@@ -0,0 +1,128 @@
+// Copyright 2026 The Shaderc Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "libshaderc_util/thread_pool.h"
+
+#include <algorithm>
+
+namespace shaderc_util {
+
+ThreadPool::ThreadPool(size_t num_threads) : pending_(0), stopping_(false) {
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t i = 0; i < num_threads; ++i) {
+    queues_.emplace_back(new Queue);
+  }
+  for (size_t i = 0; i < num_threads; ++i) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    const std::lock_guard<std::mutex> lock(wake_mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) worker.join();
+}
+
+void ThreadPool::ParallelFor(size_t count,
+                             const std::function<void(size_t)>& task) {
+  if (count == 0) return;
+
+  // Completion tracking for this call.  It lives on this stack frame, which
+  // is safe because we don't return until every task has signalled it, and
+  // the signal is the last thing a task does.
+  size_t remaining = count;
+  std::mutex done_mutex;
+  std::condition_variable done;
+
+  // Deal out contiguous runs of indices, so neighbouring jobs (which tend to
+  // be similar) start out on the same worker.
+  const size_t num_queues = queues_.size();
+  const size_t per_queue = (count + num_queues - 1) / num_queues;
+  for (size_t q = 0; q < num_queues; ++q) {
+    const size_t begin = q * per_queue;
+    const size_t end = std::min(count, begin + per_queue);
+    if (begin >= end) break;
+    const std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+    // Push in reverse, since the owner pops from the back.
+    for (size_t i = end; i-- > begin;) {
+      queues_[q]->tasks.emplace_back([&task, &remaining, &done_mutex, &done,
+                                      i]() {
+        task(i);
+        const std::lock_guard<std::mutex> done_lock(done_mutex);
+        if (--remaining == 0) done.notify_all();
+      });
+    }
+    pending_ += end - begin;
+  }
+  {
+    // Idle workers check pending_ while holding this lock, so acquiring it
+    // here guarantees none of them misses the notification.
+    const std::lock_guard<std::mutex> lock(wake_mutex_);
+  }
+  wake_.notify_all();
+
+  // Help out rather than block a thread that could be compiling.
+  Task stolen;
+  while (Steal(num_queues - 1, &stolen)) {
+    stolen();
+    stolen = nullptr;
+  }
+
+  std::unique_lock<std::mutex> done_lock(done_mutex);
+  done.wait(done_lock, [&remaining]() { return remaining == 0; });
+}
+
+bool ThreadPool::PopLocal(size_t index, Task* task) {
+  Queue& queue = *queues_[index];
+  const std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty()) return false;
+  *task = std::move(queue.tasks.back());
+  queue.tasks.pop_back();
+  --pending_;
+  return true;
+}
+
+bool ThreadPool::Steal(size_t index, Task* task) {
+  const size_t num_queues = queues_.size();
+  for (size_t offset = 1; offset <= num_queues; ++offset) {
+    Queue& queue = *queues_[(index + offset) % num_queues];
+    const std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) continue;
+    *task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    --pending_;
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+  for (;;) {
+    Task task;
+    if (PopLocal(index, &task) || Steal(index, &task)) {
+      task();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_.wait(lock, [this]() { return stopping_ || pending_.load() > 0; });
+    if (stopping_ && pending_.load() == 0) return;
+  }
+}
+
+}  // namespace shaderc_util
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <sstream>
 #include <vector>
@@ -26,6 +27,7 @@
 #include "libshaderc_util/resources.h"
 #include "libshaderc_util/spirv_tools_wrapper.h"
 #include "libshaderc_util/version_profile.h"
+#include "shaderc/layout_table.h"
 #include "shaderc_private.h"
 #include "spirv/unified1/spirv.hpp"
 
@@ -380,6 +382,173 @@ shaderc_util::Compiler::Stage GetStage(shaderc_shader_kind kind) {
   return static_cast<shaderc_util::Compiler::Stage>(0);
 }
 
+// Returns the layout table value of a field of glslang::TResourceLayout,
+// which is -1 where the field does not apply.
+uint32_t GetLayoutValue(int value) {
+  return value < 0 ? SHADERC_LAYOUT_NONE : static_cast<uint32_t>(value);
+}
+
+// Sets *kind to the shaderc_layout_kind, and *descriptor_type to the
+// VkDescriptorType value, for the given kind of glslang::TResourceLayout
+// resource.
+void GetLayoutKind(glslang::TResourceLayout::EKind resource_kind,
+                   uint32_t* kind, uint32_t* descriptor_type) {
+  switch (resource_kind) {
+    case glslang::TResourceLayout::EKindUniformBuffer:
+      *kind = shaderc_layout_kind_uniform_buffer;
+      *descriptor_type = 6;
+      return;
+    case glslang::TResourceLayout::EKindStorageBuffer:
+      *kind = shaderc_layout_kind_storage_buffer;
+      *descriptor_type = 7;
+      return;
+    case glslang::TResourceLayout::EKindSampler:
+      *kind = shaderc_layout_kind_sampler;
+      *descriptor_type = 0;
+      return;
+    case glslang::TResourceLayout::EKindSampledImage:
+      *kind = shaderc_layout_kind_sampled_image;
+      *descriptor_type = 2;
+      return;
+    case glslang::TResourceLayout::EKindCombinedImageSampler:
+      *kind = shaderc_layout_kind_combined_image_sampler;
+      *descriptor_type = 1;
+      return;
+    case glslang::TResourceLayout::EKindStorageImage:
+      *kind = shaderc_layout_kind_storage_image;
+      *descriptor_type = 3;
+      return;
+    case glslang::TResourceLayout::EKindUniformTexelBuffer:
+      *kind = shaderc_layout_kind_uniform_texel_buffer;
+      *descriptor_type = 4;
+      return;
+    case glslang::TResourceLayout::EKindStorageTexelBuffer:
+      *kind = shaderc_layout_kind_storage_texel_buffer;
+      *descriptor_type = 5;
+      return;
+    case glslang::TResourceLayout::EKindInputAttachment:
+      *kind = shaderc_layout_kind_input_attachment;
+      *descriptor_type = 10;
+      return;
+    case glslang::TResourceLayout::EKindAccelerationStructure:
+      *kind = shaderc_layout_kind_acceleration_structure;
+      *descriptor_type = 1000150000;
+      return;
+    case glslang::TResourceLayout::EKindPushConstant:
+      *kind = shaderc_layout_kind_push_constant;
+      *descriptor_type = SHADERC_LAYOUT_NONE;
+      return;
+    case glslang::TResourceLayout::EKindUniform:
+      *kind = shaderc_layout_kind_uniform;
+      *descriptor_type = SHADERC_LAYOUT_NONE;
+      return;
+    case glslang::TResourceLayout::EKindInput:
+      *kind = shaderc_layout_kind_input;
+      *descriptor_type = SHADERC_LAYOUT_NONE;
+      return;
+    case glslang::TResourceLayout::EKindOutput:
+      *kind = shaderc_layout_kind_output;
+      *descriptor_type = SHADERC_LAYOUT_NONE;
+      return;
+  }
+  assert(0 && "Should not have reached here");
+}
+
+// Returns the VkShaderStageFlagBits for a mask of glslang stages.
+uint32_t GetLayoutStages(EShLanguageMask stages) {
+  // Indexed by EShLanguage.
+  static const uint32_t kStageBits[EShLangCount] = {
+      0x1,     // vertex
+      0x2,     // tessellation control
+      0x4,     // tessellation evaluation
+      0x8,     // geometry
+      0x10,    // fragment
+      0x20,    // compute
+      0x100,   // ray generation
+      0x1000,  // intersection
+      0x200,   // any hit
+      0x400,   // closest hit
+      0x800,   // miss
+      0x2000,  // callable
+      0x40,    // task
+      0x80,    // mesh
+  };
+  uint32_t bits = 0;
+  for (int stage = 0; stage < EShLangCount; ++stage) {
+    if (stages & (1 << stage)) bits |= kStageBits[stage];
+  }
+  return bits;
+}
+
+// Returns layout, captured by glslang, as a layout table.  See
+// shaderc/layout_table.h.
+std::vector<uint32_t> WriteLayoutTable(const glslang::TResourceLayout& layout) {
+  const size_t names_words = (layout.names.size() + 3) / 4;
+  const size_t num_words =
+      sizeof(shaderc_layout_table_header) / 4 +
+      layout.resources.size() * (sizeof(shaderc_layout_resource) / 4) +
+      layout.members.size() * (sizeof(shaderc_layout_member) / 4) +
+      names_words;
+  std::vector<uint32_t> table(num_words);
+  uint32_t* words = table.data();
+
+  shaderc_layout_table_header header;
+  header.magic = SHADERC_LAYOUT_TABLE_MAGIC;
+  header.version = SHADERC_LAYOUT_TABLE_VERSION;
+  header.size = static_cast<uint32_t>(num_words * 4);
+  header.num_resources = static_cast<uint32_t>(layout.resources.size());
+  header.num_members = static_cast<uint32_t>(layout.members.size());
+  header.names_size = static_cast<uint32_t>(names_words * 4);
+  memcpy(words, &header, sizeof(header));
+  words += sizeof(header) / 4;
+
+  for (const auto& resource : layout.resources) {
+    shaderc_layout_resource record;
+    record.name = static_cast<uint32_t>(resource.name);
+    GetLayoutKind(resource.kind, &record.kind, &record.descriptor_type);
+    record.stages = GetLayoutStages(resource.stages);
+    record.set = GetLayoutValue(resource.set);
+    record.binding = GetLayoutValue(resource.binding);
+    record.location = GetLayoutValue(resource.location);
+    record.component = GetLayoutValue(resource.component);
+    record.array_size = static_cast<uint32_t>(resource.arraySize);
+    record.size = GetLayoutValue(resource.size);
+    record.numeric = static_cast<uint32_t>(resource.numeric);
+    record.width = GetLayoutValue(resource.width);
+    record.vector_size = GetLayoutValue(resource.vectorSize);
+    record.matrix_columns = static_cast<uint32_t>(resource.matrixColumns);
+    record.first_member = GetLayoutValue(resource.firstMember);
+    record.num_members = static_cast<uint32_t>(resource.numMembers);
+    memcpy(words, &record, sizeof(record));
+    words += sizeof(record) / 4;
+  }
+
+  for (const auto& member : layout.members) {
+    shaderc_layout_member record;
+    record.name = static_cast<uint32_t>(member.name);
+    record.offset = static_cast<uint32_t>(member.offset);
+    record.size = static_cast<uint32_t>(member.size);
+    record.array_size = static_cast<uint32_t>(member.arraySize);
+    record.array_stride = static_cast<uint32_t>(member.arrayStride);
+    record.matrix_stride = static_cast<uint32_t>(member.matrixStride);
+    record.flags = member.rowMajor ? SHADERC_LAYOUT_MEMBER_ROW_MAJOR : 0;
+    record.numeric = static_cast<uint32_t>(member.numeric);
+    record.width = GetLayoutValue(member.width);
+    record.vector_size = GetLayoutValue(member.vectorSize);
+    record.matrix_columns = static_cast<uint32_t>(member.matrixColumns);
+    record.first_member = GetLayoutValue(member.firstMember);
+    record.num_members = static_cast<uint32_t>(member.numMembers);
+    memcpy(words, &record, sizeof(record));
+    words += sizeof(record) / 4;
+  }
+
+  // The words of the names were zeroed, which pads them with NULs.
+  if (!layout.names.empty()) {
+    memcpy(words, layout.names.data(), layout.names.size());
+  }
+  return table;
+}
+
 }  // anonymous namespace
 
 struct shaderc_compile_options {
@@ -389,6 +558,12 @@ struct shaderc_compile_options {
   shaderc_include_resolve_fn include_resolver = nullptr;
   shaderc_include_result_release_fn include_result_releaser = nullptr;
   void* include_user_data = nullptr;
+  // When set, includes are read from the file system instead of through the
+  // callbacks above.
+  std::shared_ptr<shaderc_util::IncludeFileCache> include_file_cache;
+  shaderc_util::FileFinder include_file_finder;
+  bool collect_phase_timings = false;
+  bool generate_layout_table = false;
 };
 
 shaderc_compile_options_t shaderc_compile_options_initialize() {
@@ -443,6 +618,31 @@ void shaderc_compile_options_set_optimization_level(
   options->compiler.SetOptimizationLevel(opt_level);
 }
 
+void shaderc_compile_options_set_pool_allocator(
+    shaderc_compile_options_t options, size_t page_size, bool huge_pages,
+    size_t recycle_bytes) {
+  glslang::TPoolAllocatorOptions pool_options;
+  pool_options.pageSize = page_size;
+  pool_options.hugePages = huge_pages;
+  pool_options.recycleBytes = recycle_bytes;
+  options->compiler.SetPoolAllocatorOptions(pool_options);
+}
+
+void shaderc_compile_options_set_reuse_thread_arenas(
+    shaderc_compile_options_t options, bool enable) {
+  options->compiler.SetReuseThreadArenas(enable);
+}
+
+void shaderc_compile_options_set_collect_phase_timings(
+    shaderc_compile_options_t options, bool enable) {
+  options->collect_phase_timings = enable;
+}
+
+void shaderc_compile_options_set_generate_layout_table(
+    shaderc_compile_options_t options, bool enable) {
+  options->generate_layout_table = enable;
+}
+
 void shaderc_compile_options_set_forced_version_profile(
     shaderc_compile_options_t options, int version, shaderc_profile profile) {
   // Transfer the profile parameter from public enum type to glslang internal
@@ -472,6 +672,28 @@ void shaderc_compile_options_set_include_callbacks(
   options->include_user_data = user_data;
 }
 
+shaderc_include_file_cache_t shaderc_include_file_cache_initialize() {
+  auto* cache = new (std::nothrow) shaderc_include_file_cache;
+  if (cache) {
+    cache->cache = std::make_shared<shaderc_util::IncludeFileCache>();
+  }
+  return cache;
+}
+
+void shaderc_include_file_cache_release(shaderc_include_file_cache_t cache) {
+  delete cache;
+}
+
+void shaderc_compile_options_set_include_file_cache(
+    shaderc_compile_options_t options, shaderc_include_file_cache_t cache) {
+  options->include_file_cache = cache ? cache->cache : nullptr;
+}
+
+void shaderc_compile_options_add_include_directory(
+    shaderc_compile_options_t options, const char* directory) {
+  options->include_file_finder.search_path().push_back(directory);
+}
+
 void shaderc_compile_options_set_suppress_warnings(
     shaderc_compile_options_t options) {
   options->compiler.SetSuppressWarnings();
@@ -583,6 +805,47 @@ void shaderc_compile_options_set_nan_clamp(shaderc_compile_options_t options,
   options->compiler.SetNanClamp(enable);
 }
 
+shaderc_compilation_cache_t shaderc_compilation_cache_initialize(
+    const char* directory) {
+  auto* cache = new (std::nothrow) shaderc_compilation_cache;
+  if (cache) {
+    cache->cache = std::make_shared<shaderc_util::CompilationCache>(
+        directory ? directory : "");
+  }
+  return cache;
+}
+
+void shaderc_compilation_cache_release(shaderc_compilation_cache_t cache) {
+  delete cache;
+}
+
+void shaderc_compile_options_set_cache(shaderc_compile_options_t options,
+                                       shaderc_compilation_cache_t cache) {
+  options->compiler.SetCache(cache ? cache->cache : nullptr);
+}
+
+shaderc_precompiled_preamble_t shaderc_precompiled_preamble_create(
+    const char* text, size_t text_size, const char* name) {
+  auto* preamble = new (std::nothrow) shaderc_precompiled_preamble;
+  if (preamble) {
+    preamble->preamble = std::make_shared<glslang::TPrecompiledPreamble>(
+        text, text_size, name ? name : "");
+  }
+  return preamble;
+}
+
+void shaderc_precompiled_preamble_release(
+    shaderc_precompiled_preamble_t preamble) {
+  delete preamble;
+}
+
+void shaderc_compile_options_set_precompiled_preamble(
+    shaderc_compile_options_t options,
+    shaderc_precompiled_preamble_t preamble) {
+  options->compiler.SetPrecompiledPreamble(preamble ? preamble->preamble
+                                                    : nullptr);
+}
+
 shaderc_compiler_t shaderc_compiler_initialize() {
   shaderc_compiler_t compiler = new (std::nothrow) shaderc_compiler;
   if (compiler) {
@@ -593,15 +856,21 @@ shaderc_compiler_t shaderc_compiler_initialize() {
 
 void shaderc_compiler_release(shaderc_compiler_t compiler) { delete compiler; }
 
+void shaderc_compiler_keep_process_initialized() {
+  shaderc_util::GlslangInitializer::KeepInitializedForProcessLifetime();
+}
+
 namespace {
 shaderc_compilation_result_t CompileToSpecifiedOutputType(
     const shaderc_compiler_t compiler, const char* source_text,
     size_t source_text_size, shaderc_shader_kind shader_kind,
     const char* input_file_name, const char* entry_point_name,
     const shaderc_compile_options_t additional_options,
-    shaderc_util::Compiler::OutputType output_type) {
+    shaderc_util::Compiler::OutputType output_type, void* output_buffer,
+    size_t output_buffer_size) {
   auto* result = new (std::nothrow) shaderc_compilation_result_vector;
   if (!result) return nullptr;
+  result->SetOutputBuffer(output_buffer, output_buffer_size);
 
   if (!input_file_name) {
     result->messages = "Input file name string was null.";
@@ -623,10 +892,23 @@ shaderc_compilation_result_t CompileToSpecifiedOutputType(
     shaderc_util::string_piece source_string =
         shaderc_util::string_piece(source_text, source_text + source_text_size);
     StageDeducer stage_deducer(shader_kind);
+    std::vector<shaderc_util::Compiler::PhaseTiming> phase_timings;
+    glslang::TResourceLayout layout;
+    const bool generate_layout_table =
+        additional_options && additional_options->generate_layout_table &&
+        output_type != shaderc_util::Compiler::OutputType::PreprocessedText;
     if (additional_options) {
-      InternalFileIncluder includer(additional_options->include_resolver,
-                                    additional_options->include_result_releaser,
-                                    additional_options->include_user_data);
+      InternalFileIncluder callback_includer(
+          additional_options->include_resolver,
+          additional_options->include_result_releaser,
+          additional_options->include_user_data);
+      shaderc_util::CachingFileIncluder file_includer(
+          additional_options->include_file_cache,
+          additional_options->include_file_finder);
+      shaderc_util::CountingIncluder& includer =
+          additional_options->include_file_cache
+              ? static_cast<shaderc_util::CountingIncluder&>(file_includer)
+              : callback_includer;
       // Depends on return value optimization to avoid extra copy.
       std::tie(compilation_succeeded, compilation_output_data,
                compilation_output_data_size_in_bytes) =
@@ -637,7 +919,10 @@ shaderc_compilation_result_t CompileToSpecifiedOutputType(
               // We need to make this a reference wrapper, so that std::function
               // won't make a copy for this callable object.
               std::ref(stage_deducer), includer, output_type, &errors,
-              &total_warnings, &total_errors);
+              &total_warnings, &total_errors,
+              additional_options->collect_phase_timings ? &phase_timings
+                                                        : nullptr,
+              generate_layout_table ? &layout : nullptr);
     } else {
       // Compile with default options.
       InternalFileIncluder includer;
@@ -650,10 +935,14 @@ shaderc_compilation_result_t CompileToSpecifiedOutputType(
     }
 
     result->messages = errors.str();
-    result->SetOutputData(std::move(compilation_output_data));
-    result->output_data_size = compilation_output_data_size_in_bytes;
+    result->SetOutputData(std::move(compilation_output_data),
+                          compilation_output_data_size_in_bytes);
     result->num_warnings = total_warnings;
     result->num_errors = total_errors;
+    result->SetPhaseTimings(std::move(phase_timings));
+    if (compilation_succeeded && generate_layout_table) {
+      result->layout_table = WriteLayoutTable(layout);
+    }
     if (compilation_succeeded) {
       result->compilation_status = shaderc_compilation_status_success;
     } else {
@@ -670,6 +959,38 @@ shaderc_compilation_result_t CompileToSpecifiedOutputType(
   }
   return result;
 }
+
+// Returns a new includer for one compilation with the given options.
+std::unique_ptr<shaderc_util::CountingIncluder> MakeIncluder(
+    const shaderc_compile_options_t options) {
+  if (!options) return std::make_unique<InternalFileIncluder>();
+  if (options->include_file_cache) {
+    return std::make_unique<shaderc_util::CachingFileIncluder>(
+        options->include_file_cache, options->include_file_finder);
+  }
+  return std::make_unique<InternalFileIncluder>(
+      options->include_resolver, options->include_result_releaser,
+      options->include_user_data);
+}
+
+// Returns the compiler's batch workers, starting them if need be, or null if
+// they could not be started.
+std::shared_ptr<shaderc_util::ThreadPool> GetBatchPool(
+    const shaderc_compiler_t compiler) {
+  std::shared_ptr<shaderc_util::ThreadPool> pool;
+  TRY_IF_EXCEPTIONS_ENABLED {
+    const std::lock_guard<std::mutex> lock(compiler->batch_mutex);
+    if (!compiler->batch_pool) {
+      compiler->batch_pool = std::make_shared<shaderc_util::ThreadPool>(
+          compiler->batch_thread_count);
+    }
+    pool = compiler->batch_pool;
+  }
+  CATCH_IF_EXCEPTIONS_ENABLED(...) {
+    // Could not start the workers; the caller compiles on its own thread.
+  }
+  return pool;
+}
 }  // anonymous namespace
 
 shaderc_compilation_result_t shaderc_compile_into_spv(
@@ -680,7 +1001,153 @@ shaderc_compilation_result_t shaderc_compile_into_spv(
   return CompileToSpecifiedOutputType(
       compiler, source_text, source_text_size, shader_kind, input_file_name,
       entry_point_name, additional_options,
-      shaderc_util::Compiler::OutputType::SpirvBinary);
+      shaderc_util::Compiler::OutputType::SpirvBinary, nullptr, 0);
+}
+
+shaderc_compilation_result_t shaderc_compile_into_spv_buffer(
+    const shaderc_compiler_t compiler, const char* source_text,
+    size_t source_text_size, shaderc_shader_kind shader_kind,
+    const char* input_file_name, const char* entry_point_name,
+    const shaderc_compile_options_t additional_options, void* buffer,
+    size_t buffer_size) {
+  return CompileToSpecifiedOutputType(
+      compiler, source_text, source_text_size, shader_kind, input_file_name,
+      entry_point_name, additional_options,
+      shaderc_util::Compiler::OutputType::SpirvBinary, buffer, buffer_size);
+}
+
+void shaderc_compiler_set_batch_thread_count(shaderc_compiler_t compiler,
+                                             size_t num_threads) {
+  const std::lock_guard<std::mutex> lock(compiler->batch_mutex);
+  if (num_threads == compiler->batch_thread_count) return;
+  compiler->batch_thread_count = num_threads;
+  compiler->batch_pool.reset();
+}
+
+void shaderc_compile_batch_into_spv(const shaderc_compiler_t compiler,
+                                    const shaderc_compile_job* jobs,
+                                    size_t num_jobs,
+                                    shaderc_compilation_result_t* results) {
+  if (num_jobs == 0) return;
+
+  const std::shared_ptr<shaderc_util::ThreadPool> pool = GetBatchPool(compiler);
+  auto compile_job = [compiler, jobs, results](size_t i) {
+    const shaderc_compile_job& job = jobs[i];
+    results[i] = CompileToSpecifiedOutputType(
+        compiler, job.source_text, job.source_text_size, job.shader_kind,
+        job.input_file_name, job.entry_point_name, job.options,
+        shaderc_util::Compiler::OutputType::SpirvBinary, nullptr, 0);
+  };
+  if (pool) {
+    pool->ParallelFor(num_jobs, compile_job);
+  } else {
+    for (size_t i = 0; i < num_jobs; ++i) compile_job(i);
+  }
+}
+
+shaderc_compilation_status shaderc_compile_pipeline_into_spv(
+    const shaderc_compiler_t compiler, const shaderc_pipeline_stage* stages,
+    size_t num_stages, const shaderc_compile_options_t additional_options,
+    shaderc_compilation_result_t* results) {
+  std::vector<shaderc_compilation_result_vector*> stage_results(num_stages);
+  for (size_t i = 0; i < num_stages; ++i) {
+    stage_results[i] = new (std::nothrow) shaderc_compilation_result_vector;
+    results[i] = stage_results[i];
+    if (!stage_results[i]) {
+      for (size_t j = 0; j < i; ++j) {
+        delete stage_results[j];
+        results[j] = nullptr;
+      }
+      return shaderc_compilation_status_internal_error;
+    }
+    stage_results[i]->compilation_status =
+        shaderc_compilation_status_invalid_stage;
+  }
+  if (num_stages == 0 || !compiler->initializer) {
+    return shaderc_compilation_status_invalid_stage;
+  }
+
+  shaderc_compilation_status status =
+      shaderc_compilation_status_compilation_error;
+  std::vector<shaderc_util::Compiler::PipelineStage> util_stages(num_stages);
+  std::vector<std::unique_ptr<shaderc_util::CountingIncluder>> includers;
+  bool stages_valid = true;
+  for (size_t i = 0; i < num_stages; ++i) {
+    const shaderc_pipeline_stage& stage = stages[i];
+    shaderc_compilation_result_vector* result = stage_results[i];
+    result->compilation_status = shaderc_compilation_status_compilation_error;
+    if (!stage.input_file_name) {
+      result->messages = "Input file name string was null.";
+      result->num_errors = 1;
+      stages_valid = false;
+      continue;
+    }
+    const EShLanguage forced_stage = GetForcedStage(stage.shader_kind);
+    if (forced_stage == EShLangCount) {
+      result->messages = std::string(stage.input_file_name) +
+                         ": error: a pipeline stage needs a specific shader "
+                         "kind\n";
+      result->num_errors = 1;
+      result->compilation_status = shaderc_compilation_status_invalid_stage;
+      status = shaderc_compilation_status_invalid_stage;
+      stages_valid = false;
+      continue;
+    }
+    util_stages[i].source = shaderc_util::string_piece(
+        stage.source_text, stage.source_text + stage.source_text_size);
+    util_stages[i].stage = forced_stage;
+    util_stages[i].error_tag = stage.input_file_name;
+    util_stages[i].entry_point_name = stage.entry_point_name;
+  }
+  if (!stages_valid) return status;
+
+  TRY_IF_EXCEPTIONS_ENABLED {
+    for (size_t i = 0; i < num_stages; ++i) {
+      includers.push_back(MakeIncluder(additional_options));
+      util_stages[i].includer = includers.back().get();
+    }
+    const std::shared_ptr<shaderc_util::ThreadPool> pool =
+        GetBatchPool(compiler);
+    std::vector<shaderc_util::Compiler::PipelineStageResult> outputs;
+    glslang::TResourceLayout layout;
+    const bool generate_layout_table =
+        additional_options && additional_options->generate_layout_table;
+    bool succeeded;
+    if (additional_options) {
+      succeeded = additional_options->compiler.CompilePipeline(
+          util_stages, pool.get(), &outputs,
+          generate_layout_table ? &layout : nullptr);
+    } else {
+      // Compile with default options.
+      succeeded = shaderc_util::Compiler().CompilePipeline(
+          util_stages, pool.get(), &outputs);
+    }
+
+    status = succeeded ? shaderc_compilation_status_success
+                       : shaderc_compilation_status_compilation_error;
+    std::vector<uint32_t> layout_table;
+    if (succeeded && generate_layout_table) {
+      layout_table = WriteLayoutTable(layout);
+    }
+    for (size_t i = 0; i < num_stages; ++i) {
+      shaderc_compilation_result_vector* result = stage_results[i];
+      shaderc_util::Compiler::PipelineStageResult& output = outputs[i];
+      result->messages = std::move(output.messages);
+      result->num_warnings = output.num_warnings;
+      result->num_errors = output.num_errors;
+      const size_t size_in_bytes = output.spirv.size() * sizeof(uint32_t);
+      result->SetOutputData(std::move(output.spirv), size_in_bytes);
+      result->layout_table = layout_table;
+      result->compilation_status = status;
+    }
+  }
+  CATCH_IF_EXCEPTIONS_ENABLED(...) {
+    status = shaderc_compilation_status_internal_error;
+    for (shaderc_compilation_result_vector* result : stage_results) {
+      result->compilation_status = status;
+    }
+  }
+  return status;
 }
 
 shaderc_compilation_result_t shaderc_compile_into_spv_assembly(
@@ -691,7 +1158,7 @@ shaderc_compilation_result_t shaderc_compile_into_spv_assembly(
   return CompileToSpecifiedOutputType(
       compiler, source_text, source_text_size, shader_kind, input_file_name,
       entry_point_name, additional_options,
-      shaderc_util::Compiler::OutputType::SpirvAssemblyText);
+      shaderc_util::Compiler::OutputType::SpirvAssemblyText, nullptr, 0);
 }
 
 shaderc_compilation_result_t shaderc_compile_into_preprocessed_text(
@@ -702,7 +1169,165 @@ shaderc_compilation_result_t shaderc_compile_into_preprocessed_text(
   return CompileToSpecifiedOutputType(
       compiler, source_text, source_text_size, shader_kind, input_file_name,
       entry_point_name, additional_options,
-      shaderc_util::Compiler::OutputType::PreprocessedText);
+      shaderc_util::Compiler::OutputType::PreprocessedText, nullptr, 0);
+}
+
+shaderc_compilation_result_t shaderc_compile_into_preprocessed_text_callback(
+    const shaderc_compiler_t compiler, const char* source_text,
+    size_t source_text_size, shaderc_shader_kind, const char* input_file_name,
+    const char*, const shaderc_compile_options_t additional_options,
+    shaderc_preprocessed_text_callback callback, void* user_data) {
+  auto* result = new (std::nothrow) shaderc_compilation_result_vector;
+  if (!result) return nullptr;
+
+  if (!input_file_name) {
+    result->messages = "Input file name string was null.";
+    result->num_errors = 1;
+    result->compilation_status = shaderc_compilation_status_compilation_error;
+    return result;
+  }
+  if (!callback) {
+    result->messages = "Preprocessed text callback was null.";
+    result->num_errors = 1;
+    result->compilation_status = shaderc_compilation_status_compilation_error;
+    return result;
+  }
+  result->compilation_status = shaderc_compilation_status_invalid_stage;
+  bool preprocessing_succeeded = false;  // In case we exit early.
+  if (!compiler->initializer) return result;
+  TRY_IF_EXCEPTIONS_ENABLED {
+    std::stringstream errors;
+    size_t total_warnings = 0;
+    size_t total_errors = 0;
+    std::string input_file_name_str(input_file_name);
+    shaderc_util::string_piece source_string =
+        shaderc_util::string_piece(source_text, source_text + source_text_size);
+    auto text_sink = [callback,
+                      user_data](const shaderc_util::string_piece& text) {
+      callback(user_data, text.data(), text.size());
+    };
+    if (additional_options) {
+      InternalFileIncluder callback_includer(
+          additional_options->include_resolver,
+          additional_options->include_result_releaser,
+          additional_options->include_user_data);
+      shaderc_util::CachingFileIncluder file_includer(
+          additional_options->include_file_cache,
+          additional_options->include_file_finder);
+      shaderc_util::CountingIncluder& includer =
+          additional_options->include_file_cache
+              ? static_cast<shaderc_util::CountingIncluder&>(file_includer)
+              : callback_includer;
+      preprocessing_succeeded = additional_options->compiler.PreprocessToSink(
+          source_string, input_file_name_str, includer, text_sink, &errors,
+          &total_warnings, &total_errors);
+    } else {
+      // Preprocess with default options.
+      InternalFileIncluder includer;
+      preprocessing_succeeded = shaderc_util::Compiler().PreprocessToSink(
+          source_string, input_file_name_str, includer, text_sink, &errors,
+          &total_warnings, &total_errors);
+    }
+
+    result->messages = errors.str();
+    result->num_warnings = total_warnings;
+    result->num_errors = total_errors;
+    result->compilation_status =
+        preprocessing_succeeded ? shaderc_compilation_status_success
+                                : shaderc_compilation_status_compilation_error;
+  }
+  CATCH_IF_EXCEPTIONS_ENABLED(...) {
+    result->compilation_status = shaderc_compilation_status_internal_error;
+  }
+  return result;
+}
+
+namespace {
+// Returns path escaped for use as a target or prerequisite in a Makefile.
+std::string EscapeForMakefile(const std::string& path) {
+  std::string escaped;
+  for (const char c : path) {
+    if (c == ' ' || c == '#') {
+      escaped += '\\';
+    } else if (c == '$') {
+      escaped += '$';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+}  // anonymous namespace
+
+shaderc_compilation_result_t shaderc_scan_dependencies(
+    const shaderc_compiler_t compiler, const char* source_text,
+    size_t source_text_size, const char* input_file_name,
+    const char* depfile_target,
+    const shaderc_compile_options_t additional_options) {
+  auto* result = new (std::nothrow) shaderc_compilation_result_vector;
+  if (!result) return nullptr;
+
+  if (!input_file_name) {
+    result->messages = "Input file name string was null.";
+    result->num_errors = 1;
+    result->compilation_status = shaderc_compilation_status_compilation_error;
+    return result;
+  }
+  result->compilation_status = shaderc_compilation_status_invalid_stage;
+  bool scan_succeeded = false;  // In case we exit early.
+  if (!compiler->initializer) return result;
+  TRY_IF_EXCEPTIONS_ENABLED {
+    std::stringstream errors;
+    size_t total_warnings = 0;
+    size_t total_errors = 0;
+    std::string input_file_name_str(input_file_name);
+    shaderc_util::string_piece source_string =
+        shaderc_util::string_piece(source_text, source_text + source_text_size);
+    glslang::TShader::Dependencies dependencies;
+    if (additional_options) {
+      InternalFileIncluder callback_includer(
+          additional_options->include_resolver,
+          additional_options->include_result_releaser,
+          additional_options->include_user_data);
+      shaderc_util::CachingFileIncluder file_includer(
+          additional_options->include_file_cache,
+          additional_options->include_file_finder);
+      shaderc_util::CountingIncluder& includer =
+          additional_options->include_file_cache
+              ? static_cast<shaderc_util::CountingIncluder&>(file_includer)
+              : callback_includer;
+      scan_succeeded = additional_options->compiler.ScanDependencies(
+          source_string, input_file_name_str, includer, &dependencies,
+          &errors, &total_warnings, &total_errors);
+    } else {
+      // Scan with default options.
+      InternalFileIncluder includer;
+      scan_succeeded = shaderc_util::Compiler().ScanDependencies(
+          source_string, input_file_name_str, includer, &dependencies,
+          &errors, &total_warnings, &total_errors);
+    }
+
+    if (scan_succeeded && depfile_target) {
+      std::string rule = EscapeForMakefile(depfile_target) + ": " +
+                         EscapeForMakefile(input_file_name_str);
+      for (const auto& file : dependencies.includes) {
+        rule += " \\\n  " + EscapeForMakefile(file);
+      }
+      rule += "\n";
+      result->SetOutputData(shaderc_util::ConvertStringToVector(rule),
+                            rule.size());
+    }
+    result->messages = errors.str();
+    result->num_warnings = total_warnings;
+    result->num_errors = total_errors;
+    result->SetDependencies(std::move(dependencies));
+    result->compilation_status =
+        scan_succeeded ? shaderc_compilation_status_success
+                       : shaderc_compilation_status_compilation_error;
+  }
+  CATCH_IF_EXCEPTIONS_ENABLED(...) {
+    result->compilation_status = shaderc_compilation_status_internal_error;
+  }
+  return result;
 }
 
 shaderc_compilation_result_t shaderc_assemble_into_spv(
@@ -773,6 +1398,31 @@ const char* shaderc_result_get_error_message(
   return result->messages.c_str();
 }
 
+size_t shaderc_result_get_phase_timings(
+    const shaderc_compilation_result_t result,
+    const shaderc_phase_timing** timings) {
+  *timings = result->phase_timing_views.data();
+  return result->phase_timing_views.size();
+}
+
+size_t shaderc_result_get_included_files(
+    const shaderc_compilation_result_t result, const char* const** files) {
+  *files = result->included_file_views.data();
+  return result->included_file_views.size();
+}
+
+size_t shaderc_result_get_tested_macros(
+    const shaderc_compilation_result_t result, const char* const** macros) {
+  *macros = result->tested_macro_views.data();
+  return result->tested_macro_views.size();
+}
+
+const void* shaderc_result_get_layout_table(
+    const shaderc_compilation_result_t result, size_t* size) {
+  *size = result->layout_table.size() * sizeof(uint32_t);
+  return result->layout_table.empty() ? nullptr : result->layout_table.data();
+}
+
 shaderc_compilation_status shaderc_result_get_compilation_status(
     const shaderc_compilation_result_t result) {
   return result->compilation_status;
@@ -17,12 +17,17 @@
 
 #include <cassert>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "shaderc/shaderc.h"
 
 #include "libshaderc_util/compiler.h"
+#include "libshaderc_util/include_file_cache.h"
+#include "libshaderc_util/thread_pool.h"
 #include "spirv-tools/libspirv.h"
 
 // Described in shaderc.h.
@@ -43,6 +48,42 @@ struct shaderc_compilation_result {
   // Compilation status.
   shaderc_compilation_status compilation_status =
       shaderc_compilation_status_null_result_object;
+
+  // Sets the phase timings, and the views of them handed out by
+  // shaderc_result_get_phase_timings().
+  void SetPhaseTimings(
+      std::vector<shaderc_util::Compiler::PhaseTiming>&& timings) {
+    phase_timings = std::move(timings);
+    phase_timing_views.clear();
+    phase_timing_views.reserve(phase_timings.size());
+    for (const auto& timing : phase_timings) {
+      phase_timing_views.push_back(
+          {timing.name.c_str(), timing.wall_seconds, timing.pool_bytes});
+    }
+  }
+  std::vector<shaderc_util::Compiler::PhaseTiming> phase_timings;
+  std::vector<shaderc_phase_timing> phase_timing_views;
+
+  // Sets the dependencies found by shaderc_scan_dependencies(), and the views
+  // of them handed out by shaderc_result_get_included_files() and
+  // shaderc_result_get_tested_macros().
+  void SetDependencies(glslang::TShader::Dependencies&& found) {
+    dependencies = std::move(found);
+    included_file_views.clear();
+    for (const auto& file : dependencies.includes) {
+      included_file_views.push_back(file.c_str());
+    }
+    tested_macro_views.clear();
+    for (const auto& macro : dependencies.testedMacros) {
+      tested_macro_views.push_back(macro.c_str());
+    }
+  }
+  glslang::TShader::Dependencies dependencies;
+  std::vector<const char*> included_file_views;
+  std::vector<const char*> tested_macro_views;
+
+  // The layout table handed out by shaderc_result_get_layout_table(), if any.
+  std::vector<uint32_t> layout_table;
 };
 
 // Compilation result class using a vector for holding the compilation
@@ -51,15 +92,37 @@ class shaderc_compilation_result_vector : public shaderc_compilation_result {
  public:
   ~shaderc_compilation_result_vector() = default;
 
-  void SetOutputData(std::vector<uint32_t>&& data) {
+  // Directs subsequent output that fits within buffer_size bytes into the
+  // caller-owned buffer, instead of keeping it in this result.
+  void SetOutputBuffer(void* buffer, size_t buffer_size) {
+    output_buffer_ = static_cast<char*>(buffer);
+    output_buffer_size_ = buffer_size;
+  }
+
+  // Sets the output data, of which the first size_in_bytes bytes are used.
+  void SetOutputData(std::vector<uint32_t>&& data, size_t size_in_bytes) {
+    output_data_size = size_in_bytes;
+    if (output_buffer_ && size_in_bytes <= output_buffer_size_) {
+      if (size_in_bytes) memcpy(output_buffer_, data.data(), size_in_bytes);
+      output_in_buffer_ = true;
+      return;
+    }
+    output_in_buffer_ = false;
     output_data_ = std::move(data);
   }
 
   const char* GetBytes() const override {
+    if (output_in_buffer_) return output_buffer_;
     return reinterpret_cast<const char*>(output_data_.data());
   }
 
  private:
+  // The caller-owned buffer set by SetOutputBuffer(), and its size in bytes.
+  char* output_buffer_ = nullptr;
+  size_t output_buffer_size_ = 0;
+  // True if the output was written to output_buffer_.
+  bool output_in_buffer_ = false;
+
   // Compilation output data. In normal compilation mode, it contains the
   // compiled SPIR-V binary code. In disassembly and preprocessing-only mode, it
   // contains a null-terminated string which is the text output. For text
@@ -91,6 +154,27 @@ class GlslangInitializer;
 
 struct shaderc_compiler {
   std::unique_ptr<shaderc_util::GlslangInitializer> initializer;
+
+  // Workers for batch compilation, started lazily by the first batch.  Held
+  // by shared_ptr so that a running batch keeps its pool alive even if the
+  // thread count is changed meanwhile.  Guarded by batch_mutex.
+  std::mutex batch_mutex;
+  size_t batch_thread_count = 0;
+  std::shared_ptr<shaderc_util::ThreadPool> batch_pool;
+};
+
+// Described in shaderc.h.  The underlying cache is shared with every set of
+// compile options it has been set on.
+struct shaderc_compilation_cache {
+  std::shared_ptr<shaderc_util::CompilationCache> cache;
+};
+
+struct shaderc_include_file_cache {
+  std::shared_ptr<shaderc_util::IncludeFileCache> cache;
+};
+
+struct shaderc_precompiled_preamble {
+  std::shared_ptr<glslang::TPrecompiledPreamble> preamble;
 };
 
 // Converts a shader stage from shaderc_shader_kind into a shaderc_util::Compiler::Stage.
@@ -16,6 +16,7 @@
 
 #include <cassert>
 #include <charconv>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <system_error>
@@ -23,14 +24,20 @@
 #include <utility>
 #include <vector>
 
+#include "spirv-tools/binary.h"
 #include "spirv-tools/opt/build_module.h"
 #include "spirv-tools/opt/graphics_robust_access_pass.h"
+#include "spirv-tools/opt/ir_loader.h"
 #include "spirv-tools/opt/log.h"
 #include "spirv-tools/opt/pass_manager.h"
 #include "spirv-tools/opt/passes.h"
+#include "spirv-tools/spirv_endian.h"
 #include "spirv-tools/spirv_optimizer_options.h"
+#include "spirv-tools/table.h"
 #include "spirv-tools/util/make_unique.h"
 #include "spirv-tools/util/string_utils.h"
+#include "spirv-tools/val/validate.h"
+#include "spirv-tools/val/validation_state.h"
 
 namespace spvtools {
 
@@ -43,6 +50,46 @@ std::vector<std::string> GetVectorOfStrings(const char** strings,
   return result;
 }
 
+namespace {
+
+// Validates |binary| and, if it is valid, builds the IR for it directly from
+// the instructions the validator decoded, so that the binary is only parsed
+// once.  Returns nullptr if the binary is invalid; the reasons are reported
+// to |consumer|.
+std::unique_ptr<opt::IRContext> ValidateAndBuildModule(
+    spv_target_env env, const MessageConsumer& consumer,
+    const uint32_t* binary, const size_t binary_size,
+    spv_const_validator_options val_options) {
+  spv_context context = spvContextCreate(env);
+  SetContextMessageConsumer(context, consumer);
+  std::unique_ptr<val::ValidationState_t> vstate;
+  const spv_result_t status = val::ValidateBinaryAndKeepValidationState(
+      context, val_options, binary, binary_size, nullptr, &vstate);
+  spvContextDestroy(context);
+  if (status != SPV_SUCCESS) return nullptr;
+
+  // The validator has already checked the header, so these can not fail.
+  spv_const_binary_t const_binary = {binary, binary_size};
+  spv_endianness_t endian;
+  spv_header_t header;
+  if (spvBinaryEndianness(&const_binary, &endian) != SPV_SUCCESS ||
+      spvBinaryHeaderGet(&const_binary, endian, &header) != SPV_SUCCESS) {
+    return nullptr;
+  }
+
+  auto ir_context = MakeUnique<opt::IRContext>(env, consumer);
+  opt::IrLoader loader(consumer, ir_context->module());
+  loader.SetModuleHeader(header.magic, header.version, header.generator,
+                         header.bound, header.schema);
+  for (const auto& inst : vstate->ordered_instructions()) {
+    if (!loader.AddInstruction(&inst.c_inst())) return nullptr;
+  }
+  loader.EndModule();
+  return ir_context;
+}
+
+}  // namespace
+
 struct Optimizer::PassToken::Impl {
   Impl(std::unique_ptr<opt::Pass> p) : pass(std::move(p)) {}
 
@@ -71,6 +118,8 @@ struct Optimizer::Impl {
 
   spv_target_env target_env;      // Target environment.
   opt::PassManager pass_manager;  // Internal implementation pass manager.
+  // Where Run() records how long each step takes, or null.
+  std::vector<std::pair<std::string, double>>* pass_timings = nullptr;
   std::unordered_set<uint32_t> live_locs;  // Arg to debug dead output passes
 };
 
@@ -680,17 +729,28 @@ bool Optimizer::Run(const uint32_t* original_binary,
                     const size_t original_binary_size,
                     std::vector<uint32_t>* optimized_binary,
                     const spv_optimizer_options opt_options) const {
-  spvtools::SpirvTools tools(impl_->target_env);
-  tools.SetMessageConsumer(impl_->pass_manager.consumer());
-  if (opt_options->run_validator_ &&
-      !tools.Validate(original_binary, original_binary_size,
-                      &opt_options->val_options_)) {
-    return false;
-  }
-
-  std::unique_ptr<opt::IRContext> context = BuildModule(
-      impl_->target_env, consumer(), original_binary, original_binary_size);
+  // Records the wall time since |start| as the step |name|.
+  auto record = [this](const char* name,
+                       std::chrono::steady_clock::time_point start) {
+    if (impl_->pass_timings) {
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      impl_->pass_timings->emplace_back(name, elapsed.count());
+    }
+  };
+
+  // When validating, the IR is built from the validator's decoded
+  // instructions rather than parsing the binary a second time.
+  auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<opt::IRContext> context =
+      opt_options->run_validator_
+          ? ValidateAndBuildModule(impl_->target_env, consumer(),
+                                   original_binary, original_binary_size,
+                                   &opt_options->val_options_)
+          : BuildModule(impl_->target_env, consumer(), original_binary,
+                        original_binary_size);
   if (context == nullptr) return false;
+  record("read-module", start);
 
   context->set_max_id_bound(opt_options->max_id_bound_);
   context->set_preserve_bindings(opt_options->preserve_bindings_);
@@ -734,8 +794,10 @@ bool Optimizer::Run(const uint32_t* original_binary,
 
   // Note that |original_binary| and |optimized_binary| may share the same
   // buffer and the below will invalidate |original_binary|.
+  start = std::chrono::steady_clock::now();
   optimized_binary->clear();
   context->module()->ToBinary(optimized_binary, /* skip_nop = */ true);
+  record("write-module", start);
 
   return true;
 }
@@ -750,6 +812,13 @@ Optimizer& Optimizer::SetTimeReport(std::ostream* out) {
   return *this;
 }
 
+Optimizer& Optimizer::SetPassTimings(
+    std::vector<std::pair<std::string, double>>* timings) {
+  impl_->pass_timings = timings;
+  impl_->pass_manager.SetPassTimings(timings);
+  return *this;
+}
+
 Optimizer& Optimizer::SetValidateAfterAll(bool validate) {
   impl_->pass_manager.SetValidateAfterAll(validate);
   return *this;
@@ -14,6 +14,7 @@
 
 #include "spirv-tools/opt/pass_manager.h"
 
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -55,7 +56,13 @@ Pass::Status PassManager::Run(IRContext* context) {
   for (auto& pass : passes_) {
     print_disassembly("; IR before pass ", pass.get());
     SPIRV_TIMER_SCOPED(time_report_stream_, (pass ? pass->name() : ""), true);
+    const auto start = std::chrono::steady_clock::now();
     const auto one_status = pass->Run(context);
+    if (pass_timings_) {
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      pass_timings_->emplace_back(pass->name(), elapsed.count());
+    }
     if (one_status == Pass::Status::Failure) return one_status;
     if (one_status == Pass::Status::SuccessWithChange) status = one_status;
 
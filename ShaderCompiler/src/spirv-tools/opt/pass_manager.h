@@ -17,6 +17,7 @@
 
 #include <memory>
 #include <ostream>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -44,6 +45,7 @@ class PassManager {
       : consumer_(nullptr),
         print_all_stream_(nullptr),
         time_report_stream_(nullptr),
+        pass_timings_(nullptr),
         target_env_(SPV_ENV_UNIVERSAL_1_2),
         val_options_(nullptr),
         validate_after_all_(false) {}
@@ -92,6 +94,14 @@ class PassManager {
     return *this;
   }
 
+  // Sets a list to append the name and wall time, in seconds, of each pass
+  // run to.  Nothing is recorded if |timings| is null.
+  PassManager& SetPassTimings(
+      std::vector<std::pair<std::string, double>>* timings) {
+    pass_timings_ = timings;
+    return *this;
+  }
+
   // Sets the target environment for validation.
   PassManager& SetTargetEnv(spv_target_env env) {
     target_env_ = env;
@@ -121,6 +131,8 @@ class PassManager {
   // The output stream to write the resource utilization of each pass. If this
   // is null, no output is generated.
   std::ostream* time_report_stream_;
+  // The list to record the wall time of each pass in, or null.
+  std::vector<std::pair<std::string, double>>* pass_timings_;
   // The target environment.
   spv_target_env target_env_;
   // The validator options (used when validating each pass).